@@ -0,0 +1,125 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Atoms: small integers for tag and prefix names. With XML_ATOMS option
+ * parser interns each distinct tag and prefix into a symbol table of
+ * document (doc->atoms) and stores atom of tag in xml_t.atom, so tags can be
+ * compared with an integer compare or dispatched with a switch instead of
+ * comparing bytes.
+ *
+ * Atoms of document are given in order of first occurrence. To get stable
+ * atoms, register names once in a table and set it as base of documents;
+ * names of base keep their atoms and other names get atoms after them:
+ *
+ *   enum { A_ITEM = 1, A_NAME = 2 };
+ *
+ *   names = xml_atoms_new();
+ *   xml_atoms_add(names, "item");  // 1
+ *   xml_atoms_add(names, "name");  // 2
+ *
+ *   doc = xml_doc_new(NULL);
+ *   doc->atombase = names;
+ *   xml_parse_doc(doc, contents, len, XML_DEFAULTS | XML_ATOMS);
+ *
+ *   for (it = doc->root->val; it; it = it->next) {
+ *     switch (it->atom) {
+ *       case A_ITEM: ... break;
+ *       case A_NAME: ... break;
+ *     }
+ *   }
+ *
+ * Base table is only read by parser, so it can be shared by documents which
+ * are parsed concurrently, but names must not be added while it is in use.
+ */
+
+#ifndef xml_atom_h
+#define xml_atom_h
+
+#include "common.h"
+
+/*!
+ * @brief create an empty table to register names, atoms start from 1
+ *
+ * @return table or NULL, free it with xml_atoms_free()
+ */
+XML_INLINE
+xml_atoms_t*
+xml_atoms_new(void);
+
+/*!
+ * @brief add name to table, name is copied
+ *
+ * @param[in] atoms table which is created by xml_atoms_new()
+ * @param[in] name  null terminated tag or prefix
+ * @return atom of name (existing one if name is already added), 0 on error
+ */
+XML_INLINE
+uint32_t
+xml_atoms_add(xml_atoms_t * __restrict atoms, const char * __restrict name);
+
+/*!
+ * @brief frees table which is created by xml_atoms_new()
+ */
+XML_INLINE
+void
+xml_atoms_free(xml_atoms_t * __restrict atoms);
+
+/*!
+ * @brief find atom of name in table and its base tables
+ *
+ * @param[in] atoms    table or NULL
+ * @param[in] name     name
+ * @param[in] namesize length of name
+ * @return atom or 0 if name is not in table
+ */
+XML_INLINE
+uint32_t
+xml_atoms_find(const xml_atoms_t * __restrict atoms,
+               const char        * __restrict name,
+               size_t                         namesize);
+
+/*!
+ * @brief atom of name in document, doc->atoms or doc->atombase is used
+ *
+ * @param[in] doc  document
+ * @param[in] name null terminated name
+ * @return atom or 0 if name is not in document
+ */
+XML_INLINE
+uint32_t
+xml_atom(const xml_doc_t * __restrict doc, const char * __restrict name);
+
+XML_INLINE
+uint32_t
+xml_atom_sz(const xml_doc_t * __restrict doc,
+            const char      * __restrict name,
+            size_t                       namesize);
+
+/*!
+ * @brief atom of prefix of element
+ *
+ * prefixes are interned too but only atom of tag is stored in element, this
+ * finds atom of prefix in table.
+ *
+ * @param[in] doc    document which is parsed with XML_ATOMS
+ * @param[in] object element
+ * @return atom or 0 if element has no prefix
+ */
+XML_INLINE
+uint32_t
+xml_prefix_atom(const xml_doc_t * __restrict doc,
+                const xml_t     * __restrict object);
+
+/*
+ * xml.h is included after declarations: parser includes this header too (via
+ * impl_atom.h), so declarations must be ready if xml.h is included from here
+ */
+#include "xml.h"
+#include "impl/impl_atom.h"
+
+#endif /* xml_atom_h */
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Binary documents: a tree is saved once as a position independent image,
+ * nodes and attributes are fixed size records which refer each other with
+ * indices and refer strings with offsets, so loading is mapping the file
+ * and checking its header, nothing is parsed, allocated or relocated:
+ *
+ *   xml_doc_save_binary(doc, "catalog.xmlb");
+ *   ...
+ *   bin  = xml_doc_load_binary("catalog.xmlb");
+ *   root = xml_bin_root(bin);
+ *   item = xml_bin_elem(bin, root, "item");
+ *   while (item) {
+ *     ... xml_bin_attr(bin, item, "id"), xml_bin_text(bin, item)
+ *     item = xml_bin_elem_next(bin, item, "item");
+ *   }
+ *   xml_bin_free(bin);
+ *
+ * Layout (all records are 8 byte aligned):
+ *
+ *   xml_bin_header_t
+ *   xml_bin_node_t[nnodes]  nodes in list order, depth-first: first child of
+ *                           node i is node i + 1, node 0 is root
+ *   xml_bin_attr_t[nattrs]  attributes of each element are contiguous
+ *   strings                 tags, names and values, each is followed by '\0'
+ *
+ * Strings are stored as they are in tree (raw or decoded, see `flags`), so
+ * they can be decoded with xml/entity.h. Files are checked for byte order,
+ * version and layout sizes, images which are written on another platform
+ * with different byte order are rejected. Records are checked once while
+ * loading (indices and string offsets are in range, siblings and parents
+ * are in depth-first order), so walking a corrupt image can't read outside
+ * of it or loop. Contents of strings are not checked.
+ *
+ * POSIX and Windows are supported, on POSIX systems compile with
+ * _POSIX_C_SOURCE >= 200112L or _DEFAULT_SOURCE if you are using a strict C
+ * standard mode e.g. -std=c99.
+ */
+
+#ifndef xml_binary_h
+#define xml_binary_h
+
+#include "common.h"
+#include "xml.h"
+#include "serialize.h"
+#include "file.h"
+
+#define XML_BIN_VERSION 1
+#define XML_BIN_ORDER   0x01020304u
+
+/* flags of nodes and attributes */
+#define XML_BIN_ENTITY  1 /* value contains '&', see xml_t.entity      */
+#define XML_BIN_DECODED 2 /* value is plain text, see xml_t.decoded    */
+
+typedef struct xml_bin_header_t {
+  char     magic[4];  /* "XMLB"                                      */
+  uint32_t version;   /* XML_BIN_VERSION                              */
+  uint32_t order;     /* XML_BIN_ORDER in byte order of writer        */
+  uint32_t nodesize;  /* sizeof(xml_bin_node_t)                       */
+  uint32_t attrsize;  /* sizeof(xml_bin_attr_t)                       */
+  uint32_t reserved;
+  uint64_t size;      /* size of image                                */
+  uint64_t nnodes;
+  uint64_t nattrs;
+  uint64_t strings;   /* offset of strings in image                   */
+  uint64_t strsize;   /* size of strings                              */
+} xml_bin_header_t;
+
+typedef struct xml_bin_node_t {
+  uint64_t str;        /* offset of tag or value in strings           */
+  uint32_t size;       /* size of tag or value                        */
+  uint32_t parent;     /* index of parent, 0 for children of root     */
+  uint32_t next;       /* index of next sibling or 0                  */
+  uint32_t attr;       /* index of first attribute                    */
+  uint32_t nattrs;     /* number of attributes                        */
+  uint16_t prefixsize; /* prefix is before tag and ':', 0 if no prefix */
+  uint8_t  type;       /* xml_type_t                                  */
+  uint8_t  flags;      /* XML_BIN_ENTITY, XML_BIN_DECODED             */
+} xml_bin_node_t;
+
+typedef struct xml_bin_attr_t {
+  uint64_t name;       /* offset of name in strings                   */
+  uint64_t val;        /* offset of value in strings                  */
+  uint16_t namesize;
+  uint16_t valsize;
+  uint8_t  namequote;
+  uint8_t  valquote;
+  uint8_t  flags;      /* XML_BIN_ENTITY, XML_BIN_DECODED             */
+  uint8_t  reserved;
+} xml_bin_attr_t;
+
+typedef struct xml_bin_t {
+  const xml_bin_node_t *nodes;
+  const xml_bin_attr_t *attrs;
+  const char           *strings;
+  uint32_t              nnodes;
+  uint32_t              nattrs;
+  void                 *map;     /* mapped file owned by xml_bin_t or NULL */
+  size_t                mapsize;
+} xml_bin_t;
+
+/*!
+ * @brief write binary image of root and its subtree
+ *
+ * @param[in] w    writer, see xml/serialize.h, it is flushed at the end
+ * @param[in] root root element
+ * @return false if writer is failed, allocation fails or tree has more than
+ *         UINT32_MAX - 1 nodes or attributes
+ */
+XML_INLINE
+bool
+xml_bin_write(xml_writer_t * __restrict w, const xml_t * __restrict root);
+
+/*!
+ * @brief save document as binary image to file, file is truncated
+ *
+ * @param[in] doc  document
+ * @param[in] path file path
+ * @return false if document has no root element or writing fails
+ */
+XML_INLINE
+bool
+xml_doc_save_binary(const xml_doc_t * __restrict doc,
+                    const char      * __restrict path);
+
+/*!
+ * @brief use image in memory e.g. from xml_bin_write() with memory sink
+ *
+ * data must be 8 byte aligned (malloc'd buffer is) and alive while bin is
+ * used, it is not copied.
+ *
+ * @param[out] bin  binary document
+ * @param[in]  data image
+ * @param[in]  size size of image
+ * @return false if header or records are not valid
+ */
+XML_INLINE
+bool
+xml_bin_open(xml_bin_t * __restrict bin, const void * __restrict data,
+             size_t size);
+
+/*!
+ * @brief map binary image file read-only, free it with xml_bin_free()
+ *
+ * @return binary document or NULL if file couldn't be mapped or image is
+ *         not valid
+ */
+XML_INLINE
+xml_bin_t*
+xml_doc_load_binary(const char * __restrict path);
+
+/*!
+ * @brief unmap and free binary document which is loaded from file
+ */
+XML_INLINE
+void
+xml_bin_free(xml_bin_t * __restrict bin);
+
+/*!
+ * @brief root element
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_root(const xml_bin_t * __restrict bin);
+
+/*!
+ * @brief parent of node or NULL for root
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_parent(const xml_bin_t      * __restrict bin,
+               const xml_bin_node_t * __restrict node);
+
+/*!
+ * @brief first child of node or NULL, like xml_xml()
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_child(const xml_bin_t      * __restrict bin,
+              const xml_bin_node_t * __restrict node);
+
+/*!
+ * @brief next sibling of node or NULL
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_next(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node);
+
+/*!
+ * @brief tag of element (without prefix if it is separated) or value of
+ *        string, CDATA, comment node, it is null terminated, see node->size
+ */
+XML_INLINE
+const char*
+xml_bin_str(const xml_bin_t      * __restrict bin,
+            const xml_bin_node_t * __restrict node);
+
+/*!
+ * @brief prefix of element or NULL, it is followed by ':' not by '\0'
+ */
+XML_INLINE
+const char*
+xml_bin_prefix(const xml_bin_t      * __restrict bin,
+               const xml_bin_node_t * __restrict node);
+
+/*!
+ * @brief first child element by tag, like xml_elem_sz()
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem_sz(const xml_bin_t      * __restrict bin,
+                const xml_bin_node_t * __restrict node,
+                const char           * __restrict name,
+                size_t                            namesize);
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node,
+             const char           * __restrict name);
+
+/*!
+ * @brief next sibling element by tag, like xml_elem_next_sz()
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem_next_sz(const xml_bin_t      * __restrict bin,
+                     const xml_bin_node_t * __restrict current,
+                     const char           * __restrict name,
+                     size_t                            namesize);
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem_next(const xml_bin_t      * __restrict bin,
+                  const xml_bin_node_t * __restrict current,
+                  const char           * __restrict name);
+
+/*!
+ * @brief attribute of element by name, like xmla_sz()
+ */
+XML_INLINE
+const xml_bin_attr_t*
+xml_bin_attr_sz(const xml_bin_t      * __restrict bin,
+                const xml_bin_node_t * __restrict node,
+                const char           * __restrict name,
+                size_t                            namesize);
+
+XML_INLINE
+const xml_bin_attr_t*
+xml_bin_attr(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node,
+             const char           * __restrict name);
+
+/*!
+ * @brief null terminated name of attribute, see attr->namesize
+ */
+XML_INLINE
+const char*
+xml_bin_attr_name(const xml_bin_t      * __restrict bin,
+                  const xml_bin_attr_t * __restrict attr);
+
+/*!
+ * @brief null terminated value of attribute, see attr->valsize
+ */
+XML_INLINE
+const char*
+xml_bin_attr_val(const xml_bin_t      * __restrict bin,
+                 const xml_bin_attr_t * __restrict attr);
+
+/*!
+ * @brief first string child of element, like xmls()
+ */
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_text(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node);
+
+#include "impl/impl_binary.h"
+
+#endif /* xml_binary_h */
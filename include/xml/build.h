@@ -0,0 +1,131 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Builder: creates or changes trees without parsing. Nodes and attributes
+ * are allocated in document memory like parsed ones (no malloc per node),
+ * they are freed with document. Strings are referenced by default, so they
+ * must be alive as long as document, or they are copied into document memory
+ * with XML_BUILD_COPY:
+ *
+ *   doc  = xml_doc_new(NULL);
+ *   root = xml_elem_append(doc, NULL, "response", XML_BUILD_DEFAULT);
+ *   item = xml_elem_append(doc, root, "item", XML_BUILD_DEFAULT);
+ *
+ *   xml_attr_set(doc, item, "id", idstr, XML_BUILD_COPY);
+ *   xml_text_append(doc, item, name, namelen, XML_BUILD_COPY);
+ *
+ *   str = xml_serialize_str(doc->root, XML_SERIALIZE_DEFAULT, &len);
+ *
+ * Values are plain text by default, they are flagged with `decoded` so
+ * xml_serialize() escapes them, see xml/serialize.h. With XML_BUILD_RAW
+ * values are markup which is already escaped, they are written as they are
+ * like parsed values.
+ *
+ * Trees which are parsed can be changed too, changed elements are marked
+ * with xml_touch() so XML_SERIALIZE_SPANS doesn't copy stale contents, and
+ * lookup tables (see xmla_index(), xml_elem_index()) which would miss new
+ * nodes are dropped, they can be built again. New elements get atoms if
+ * document interns names (XML_ATOMS).
+ *
+ * Elements and attributes are appended in list order, so they are prepended
+ * in documents which are parsed with XML_REVERSE.
+ */
+
+#ifndef xml_build_h
+#define xml_build_h
+
+#include "common.h"
+#include "xml.h"
+
+typedef enum xml_build_flags_t {
+  XML_BUILD_DEFAULT = 0,
+  XML_BUILD_COPY    = 1, /* copy strings into document memory (null
+                            terminated), else they are referenced       */
+  XML_BUILD_RAW     = 2  /* value is already escaped, it is not escaped
+                            by serializer, it can be decoded with
+                            xml/entity.h (attribute values which have
+                            '&' are copied unless document is
+                            XML_READONLY, they are decoded in place)    */
+} xml_build_flags_t;
+
+/*!
+ * @brief append a new empty element to parent
+ *
+ * tag is split into prefix and tag if doc->sepPrefixes is set (XML_PREFIXES)
+ * and tag has ':'.
+ *
+ * @param[in] doc    document, memory of document is used
+ * @param[in] parent parent element or NULL to create root element
+ * @param[in] tag    tag e.g. "item" or "p:item"
+ * @param[in] flags  XML_BUILD_DEFAULT or XML_BUILD_COPY
+ * @return new element, NULL if allocation fails, tag is too long (more than
+ *         UINT16_MAX bytes), parent is not an element or document already
+ *         has a root element
+ */
+XML_INLINE
+xml_t*
+xml_elem_append(xml_doc_t  * __restrict doc,
+                xml_t      * __restrict parent,
+                const char * __restrict tag,
+                int                     flags);
+
+/*!
+ * @brief set value of attribute, attribute is appended if it doesn't exist
+ *
+ * @param[in] doc    document, memory of document is used
+ * @param[in] elem   element
+ * @param[in] name   name of attribute
+ * @param[in] val    value, plain text unless XML_BUILD_RAW is used
+ * @param[in] flags  XML_BUILD_DEFAULT or XML_BUILD_* flags
+ * @return attribute, NULL if allocation fails, name or value is too long
+ *         (more than UINT16_MAX bytes) or elem is not an element
+ */
+XML_INLINE
+xml_attr_t*
+xml_attr_set(xml_doc_t  * __restrict doc,
+             xml_t      * __restrict elem,
+             const char * __restrict name,
+             const char * __restrict val,
+             int                     flags);
+
+/*!
+ * @brief same as xml_attr_set() but value doesn't need to be null terminated
+ */
+XML_INLINE
+xml_attr_t*
+xml_attr_set_sz(xml_doc_t  * __restrict doc,
+                xml_t      * __restrict elem,
+                const char * __restrict name,
+                const char * __restrict val,
+                size_t                  valsize,
+                int                     flags);
+
+/*!
+ * @brief append a text node to parent
+ *
+ * a new node is appended even if last child is text, serializer writes
+ * them one after another.
+ *
+ * @param[in] doc    document, memory of document is used
+ * @param[in] parent parent element
+ * @param[in] text   text, plain text unless XML_BUILD_RAW is used
+ * @param[in] len    length of text
+ * @param[in] flags  XML_BUILD_DEFAULT or XML_BUILD_* flags
+ * @return text node, NULL if allocation fails or parent is not an element
+ */
+XML_INLINE
+xml_t*
+xml_text_append(xml_doc_t  * __restrict doc,
+                xml_t      * __restrict parent,
+                const char * __restrict text,
+                size_t                  len,
+                int                     flags);
+
+#include "impl/impl_build.h"
+
+#endif /* xml_build_h */
@@ -13,6 +13,8 @@ extern "C" {
 
 #include "../common.h"
 #include "../xml.h"
+#include "../tape.h"
+#include "../pool.h"
 
 /*!
  * @brief parse xml string
@@ -41,6 +43,134 @@ XML_EXPORT
 xml_doc_t*
 xmlc_parse(const char * __restrict contents, xml_options_t options);
 
+/*!
+ * @brief parse xml string with explicit length, see xml_parse_n()
+ *
+ * contents doesn't need to be NULL terminated, parser never reads past
+ * contents + len.
+ *
+ * @param[in] contents XML string (may not be NULL terminated)
+ * @param[in] len      byte length of contents
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return xml document which contains xml object as root object
+ */
+XML_EXPORT
+xml_doc_t*
+xmlc_parse_n(const char * __restrict contents,
+             size_t                   len,
+             xml_options_t            options);
+
+/*!
+ * @brief parse xml string into an existing document, see xml_parse_doc()
+ *
+ * @param[in] doc      document which is created by xmlc_doc_new()
+ * @param[in] contents XML string (may not be NULL terminated)
+ * @param[in] len      byte length of contents
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return doc or NULL if doc or contents is NULL
+ */
+XML_EXPORT
+xml_doc_t*
+xmlc_parse_doc(xml_doc_t  * __restrict doc,
+               const char * __restrict contents,
+               size_t                  len,
+               xml_options_t           options);
+
+/*!
+ * @brief create an empty document, see xml_doc_new()
+ *
+ * @param[in] allocator allocator or NULL to use malloc / free
+ * @return document or NULL if allocation fails, free it with xmlc_free()
+ */
+XML_EXPORT
+xml_doc_t*
+xmlc_doc_new(const xml_allocator_t * __restrict allocator);
+
+/*!
+ * @brief rewind document's memory for next parse, see xml_doc_reset()
+ */
+XML_EXPORT
+void
+xmlc_doc_reset(xml_doc_t * __restrict doc);
+
+/*!
+ * @brief initialize a document pool, see xml_pool_init()
+ *
+ * @param[out] pool      pool
+ * @param[in]  maxmem    max bytes which are kept by pool, 0 for no limit
+ * @param[in]  allocator allocator of new documents or NULL for malloc / free
+ */
+XML_EXPORT
+void
+xmlc_pool_init(xml_pool_t            * __restrict pool,
+               size_t                             maxmem,
+               const xml_allocator_t * __restrict allocator);
+
+/*!
+ * @brief parse xml string into a document from pool, see xml_pool_parse()
+ *
+ * @param[in] pool     pool
+ * @param[in] contents XML string (may not be NULL terminated)
+ * @param[in] len      byte length of contents
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return document, give it back with xmlc_pool_release()
+ */
+XML_EXPORT
+xml_doc_t*
+xmlc_pool_parse(xml_pool_t * __restrict pool,
+                const char * __restrict contents,
+                size_t                  len,
+                xml_options_t           options);
+
+/*!
+ * @brief give document back to pool, see xml_pool_release()
+ */
+XML_EXPORT
+void
+xmlc_pool_release(xml_pool_t * __restrict pool, xml_doc_t * __restrict doc);
+
+/*!
+ * @brief free all documents which are kept by pool, see xml_pool_destroy()
+ */
+XML_EXPORT
+void
+xmlc_pool_destroy(xml_pool_t * __restrict pool);
+
+/*!
+ * @brief map file read-only and parse it, see xml_parse_file()
+ *
+ * file is parsed with XML_READONLY semantics, document owns the mapping and
+ * it is unmapped by xmlc_free().
+ *
+ * @param[in] path    file path
+ * @param[in] options options use XML_DEFAULTS or XML_NONE for default
+ * @return xml document or NULL if file couldn't be mapped or it is empty
+ */
+XML_EXPORT
+xml_doc_t*
+xmlc_parse_file(const char * __restrict path, xml_options_t options);
+
+/*!
+ * @brief parse xml string into flat tape, see xml_parse_tape()
+ *
+ * @param[in] contents XML string, doesn't need to be null terminated
+ * @param[in] len      length of contents in bytes, must be less than 4GB
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return tape or NULL, free it with xmlc_tape_free()
+ */
+XML_EXPORT
+xml_tape_t*
+xmlc_parse_tape(const char * __restrict contents,
+                size_t                   len,
+                xml_options_t            options);
+
+/*!
+ * @brief frees tape, contents are not freed
+ */
+XML_EXPORT
+void
+xmlc_tape_free(xml_tape_t * __restrict tape);
+
 /*!
  * @brief frees xml document and its allocated memory
  */
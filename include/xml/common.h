@@ -14,6 +14,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
 #if defined(_MSC_VER)
 #  ifdef XML_DLL
 #    define XML_EXPORT __declspec(dllexport)
@@ -21,20 +25,27 @@
 #    define XML_EXPORT __declspec(dllimport)
 #  endif
 #  define XML_INLINE __forceinline
+#  define XML_STATIC static __inline
 #else
 #  define XML_EXPORT __attribute__((visibility("default")))
 #  define XML_INLINE static inline __attribute((always_inline))
+#  define XML_STATIC static inline
 #endif
 
 #define XML_ARR_LEN(ARR) (sizeof(ARR)/sizeof(ARR[0]))
 
 struct xml_t;
 struct xml_attr_t;
+struct xml_lookup_t;
+struct xml_lookup_chunk_t;
+struct xml_atoms_t;
 
 typedef enum xml_type_t {
   XML_UNKOWN  = 0,
   XML_ELEMENT = 1,
-  XML_STRING  = 2
+  XML_STRING  = 2,
+  XML_CDATA   = 3, /* payload of <![CDATA[...]]>, val / valsize like string */
+  XML_COMMENT = 4  /* payload of <!--...-->, only with XML_COMMENTS option  */
 
   /*
   XML_BOOL    = 5,
@@ -54,30 +65,133 @@ typedef struct xml_attr_t {
   uint16_t           namesize;
   uint8_t            namequote;
   uint8_t            valquote;
+  bool               entity:1;  /* value contains '&', see xml/entity.h */
+  bool               decoded:1; /* plain text, escaped when serialized  */
 } xml_attr_t;
 
 typedef struct xml_t {
-  struct xml_t      *parent;
-  struct xml_t      *next;
-  struct xml_attr_t *attr;
-  const char        *prefix;
-  const char        *tag;
-  void              *val;
-  uint32_t           valsize;
-  uint16_t           tagsize;
-  uint16_t           prefixsize;
-  xml_type_t         type:16;
-  bool               readonly:1;
-  bool               reverse:1;
+  struct xml_t        *parent;
+  struct xml_t        *next;
+  struct xml_attr_t   *attr;
+  const char          *prefix;
+  const char          *tag;
+  void                *val;
+  uint32_t             valsize;
+  uint16_t             tagsize;
+  uint16_t             prefixsize;
+  xml_type_t           type:16;
+  bool                 readonly:1;
+  bool                 reverse:1;
+  bool                 entity:1;  /* value contains '&', see xml/entity.h */
+  bool                 dirty:1;   /* changed after parse, see xml_touch() */
+  bool                 decoded:1; /* plain text, escaped when serialized  */
+  bool                 exact:1;   /* source has nothing else, xml_src()   */
+  bool                 indexed:1; /* has lookup tables, see xmla_index()  */
+  bool                 docroot:1; /* document is stored before root node  */
+  uint32_t             atom;      /* atom of tag or 0, see xml/atom.h     */
 } xml_t;
 
+/* lookup tables of element, they are allocated in document memory */
+typedef struct xml_lookup_t {
+  xml_attr_t **attrs;    /* open addressing table of attributes or NULL */
+  xml_t      **elems;    /* table of first child element by tag or NULL */
+  xml_t       *nexttag;  /* next sibling with same tag, see elems       */
+  uint32_t     attrmask; /* capacity of attrs - 1                       */
+  uint32_t     elemmask; /* capacity of elems - 1                       */
+} xml_lookup_t;
+
+#define XML_LOOKUP_CHUNK 64
+
+/* lookup tables of nodes which are near in memory, see xml_doc_t.lookups */
+typedef struct xml_lookup_chunk_t {
+  uintptr_t      key;   /* address / sizeof(xml_t) / XML_LOOKUP_CHUNK   */
+  xml_lookup_t **slots; /* XML_LOOKUP_CHUNK tables by address, or NULL  */
+} xml_lookup_chunk_t;
+
+/*
+ * memory of document (pages, document itself) is allocated with allocator,
+ * alloc must return memory which is aligned for any type like malloc does.
+ */
+typedef struct xml_allocator_t {
+  void *(*alloc)(void *ctx, size_t size);
+  void  (*free)(void *ctx, void *ptr);
+  void   *ctx;
+} xml_allocator_t;
+
+/*
+ * result of counting pre-pass, see xml_prescan(). Counts are estimations
+ * (upper bounds for usual documents) not exact numbers.
+ */
+typedef struct xml_prescan_t {
+  size_t nodes; /* elements and text nodes, number of '<'        */
+  size_t attrs; /* attributes, number of '=' (upper bound)        */
+} xml_prescan_t;
+
+typedef enum xml_error_code_t {
+  XML_OK           = 0,
+  XML_ERR_EOF      = 1, /* unexpected end of input e.g. in tag or comment */
+  XML_ERR_SYNTAX   = 2, /* unexpected character                          */
+  XML_ERR_END_TAG  = 3, /* end tag doesn't match open element            */
+  XML_ERR_ATTR     = 4, /* malformed attribute                           */
+  XML_ERR_UNCLOSED = 5, /* element is not closed at end of input         */
+  XML_ERR_NOMEM    = 6  /* memory allocation failed                      */
+} xml_error_code_t;
+
+/*
+ * first error of parse, code is XML_OK if document is well-formed (for the
+ * subset which is checked by parser)
+ */
+typedef struct xml_error_t {
+  xml_error_code_t code;
+  size_t           offset;   /* byte offset in contents                   */
+  const char      *expected; /* expected token e.g. ">", "-->" or NULL     */
+} xml_error_t;
+
+/* symbol table of tag and prefix names, see xml/atom.h */
+typedef struct xml_atom_slot_t {
+  const char *name;
+  uint32_t    namesize;
+  uint32_t    atom;     /* 0 for empty slot */
+} xml_atom_slot_t;
+
+typedef struct xml_atoms_t {
+  const struct xml_atoms_t *base;  /* searched first, e.g. registered names */
+  xml_atom_slot_t          *slots; /* open addressing table of names       */
+  uint32_t                  mask;  /* capacity of slots - 1                */
+  uint32_t                  count; /* number of names in this table        */
+  uint32_t                  next;  /* atom of next new name                */
+  bool                      owned; /* names are copied, see xml_atoms_new() */
+} xml_atoms_t;
+
 typedef struct xml_doc_t {
-  void       *memroot;
-  xml_t      *root;
-  const char *ptr;
-  bool        readonly:1;
-  bool        reverse:1;
-  bool        sepPrefixes:1;
+  void             *memroot;
+  void             *memspare; /* pages which are kept by xml_doc_reset()  */
+  xml_t            *root;
+  const char       *ptr;
+  void             *map;      /* mapped contents owned by document        */
+  size_t            mapsize;
+  void            (*unmap)(void *map, size_t mapsize);
+  xml_allocator_t   allocator;
+  xml_prescan_t     prescan;  /* only if XML_PRESCAN is used              */
+  xml_error_t       error;
+  struct xml_doc_t *poolnext; /* next free document in xml_pool_t         */
+  xml_t            *last;     /* last node which is added by builder      */
+
+  /* XML_ATOMS: symbol table of document and registered names, see atom.h */
+  struct xml_atoms_t       *atoms;
+  const struct xml_atoms_t *atombase;
+
+  /* lookup tables by address of element in chunks, see xmla_index()      */
+  struct xml_lookup_chunk_t  *lookups;    /* open addressing by chunk key */
+  uint32_t                    lookupmask; /* capacity of lookups - 1      */
+  uint32_t                    nlookups;   /* number of chunks             */
+
+  bool              readonly:1;
+  bool              reverse:1;
+  bool              sepPrefixes:1;
+  bool              comments:1;
+  bool              failfast:1;
+  bool              intern:1;
 } xml_doc_t;
 
 XML_INLINE
@@ -117,19 +231,24 @@ xml__quote_escaped(const char * __restrict begin,
 }
 
 XML_INLINE
-char *
-xml__find_quote(char * __restrict p,
-                char              quote) {
-  char *found;
-
-  while ((found = strchr(p, quote))) {
-    if (!xml__quote_escaped(p, found))
-      return found;
+int
+xml__ctz64(uint64_t x) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long r;
+  _BitScanForward64(&r, x);
+  return (int)r;
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(x);
+#else
+  int r;
 
-    p = found + 1;
+  r = 0;
+  while (!(x & 1u)) {
+    x >>= 1;
+    r++;
   }
-
-  return NULL;
+  return r;
+#endif
 }
 
 XML_INLINE
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Entity and character reference decoding: &amp; &lt; &gt; &quot; &apos;
+ * &#NNN; and &#xHHH; (as UTF-8). Other references are kept as they are.
+ *
+ * Parser doesn't decode strings, it only flags strings which contain '&'
+ * (xml_t.entity, xml_attr_t.entity) while it builds the tree; structural
+ * index already visits '&' bytes so flags are almost free. Decoding is lazy:
+ * helpers below return immediately for strings without the flag, so only
+ * strings which have references are visited again.
+ *
+ * Decoded string is never longer than the original, so it is decoded in
+ * place, or into document's memory if XML_READONLY is used.
+ */
+
+#ifndef xml_entity_h
+#define xml_entity_h
+
+#include "common.h"
+#include "xml.h"
+
+/*!
+ * @brief decode references of [src, src + len) into dst
+ *
+ * dst must have len bytes at least, dst may be equal to src (in place) but
+ * it must not overlap otherwise. dst is not null terminated.
+ *
+ * @param[out] dst destination
+ * @param[in]  src string
+ * @param[in]  len length of string
+ * @return length of decoded string
+ */
+XML_INLINE
+size_t
+xml_decode(char * dst, const char * src, size_t len);
+
+/*!
+ * @brief decode string node (e.g. returned by xmls()) if it has references
+ *
+ * obj->val and obj->valsize are updated, decoded string is null terminated.
+ * obj->decoded is set, so xml_serialize() escapes it back.
+ *
+ * @param[in] doc document of node, memory is used for XML_READONLY
+ * @param[in] obj string node
+ * @return decoded string or NULL
+ */
+XML_INLINE
+const char*
+xml_val_decode(xml_doc_t * __restrict doc, xml_t * __restrict obj);
+
+/*!
+ * @brief decode attribute value if it has references
+ *
+ * attr->val and attr->valsize are updated, decoded value is null terminated.
+ * attr->decoded is set, so xml_serialize() escapes it back.
+ *
+ * @param[in] doc  document of attribute, memory is used for XML_READONLY
+ * @param[in] attr attribute
+ * @return decoded value or NULL
+ */
+XML_INLINE
+const char*
+xmla_decode(xml_doc_t * __restrict doc, xml_attr_t * __restrict attr);
+
+/*!
+ * @brief decode all flagged strings and attribute values of document
+ *
+ * @param[in] doc document
+ */
+XML_INLINE
+void
+xml_doc_decode(xml_doc_t * __restrict doc);
+
+#include "impl/impl_entity.h"
+
+#endif /* xml_entity_h */
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Parse files by mapping them into memory instead of reading them into
+ * a malloc'd buffer, pages are shared with page cache.
+ *
+ * POSIX (mmap) and Windows (MapViewOfFile) are supported, on POSIX systems
+ * compile with _POSIX_C_SOURCE >= 200112L or _DEFAULT_SOURCE if you are
+ * using a strict C standard mode e.g. -std=c99.
+ */
+
+#ifndef xml_file_h
+#define xml_file_h
+
+#include "common.h"
+#include "xml.h"
+
+/*!
+ * @brief map file read-only and parse it
+ *
+ * File is parsed with XML_READONLY semantics (it is added to options), so
+ * mapped pages are never written (no null terminators), use valsize,
+ * namesize... to get string lengths. Document owns the mapping, it is
+ * unmapped by xml_free().
+ *
+ * @param[in] path    file path
+ * @param[in] options options use XML_DEFAULTS or XML_NONE for default
+ * @return xml document or NULL if file couldn't be mapped or it is empty
+ */
+XML_INLINE
+xml_doc_t*
+xml_parse_file(const char * __restrict path, xml_options_t options);
+
+#include "impl/impl_file.h"
+
+#endif /* xml_file_h */
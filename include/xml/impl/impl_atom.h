@@ -0,0 +1,333 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Table of document is allocated in document memory when first name is
+ * interned, names point to contents (like tags) so they are not copied. When
+ * table is grown old slots are left in document memory, total is less than
+ * twice of final table. Registered tables (xml_atoms_new()) use malloc and
+ * copy names.
+ */
+
+#ifndef xml_impl_atom_h
+#define xml_impl_atom_h
+
+#include "../atom.h"
+#include "impl_mem.h"
+#include "impl_lookup.h"
+
+#define XML__ATOM_CACHE 64
+
+/*
+ * table of document, recently interned names are cached by first byte and
+ * length so repeated tags are usually found without hashing.
+ */
+typedef struct xml__atoms_doc_t {
+  xml_atoms_t     atoms;
+  xml_atom_slot_t cache[XML__ATOM_CACHE];
+} xml__atoms_doc_t;
+
+/*!
+ * @brief slot of name or empty slot where name can be inserted
+ */
+XML_INLINE
+xml_atom_slot_t*
+xml__atoms_slot(const xml_atoms_t * __restrict atoms,
+                uint64_t                       hash,
+                const char        * __restrict name,
+                size_t                         namesize) {
+  xml_atom_slot_t *slot;
+  uint32_t         i, mask;
+
+  mask = atoms->mask;
+  i    = (uint32_t)hash & mask;
+
+  while ((slot = &atoms->slots[i])->atom) {
+    if ((size_t)slot->namesize == namesize
+        && xml__bytes_eq(slot->name, name, namesize))
+      return slot;
+
+    i = (i + 1) & mask;
+  }
+
+  return slot;
+}
+
+XML_INLINE
+uint32_t
+xml__atoms_find(const xml_atoms_t * __restrict atoms,
+                uint64_t                       hash,
+                const char        * __restrict name,
+                size_t                         namesize) {
+  uint32_t atom;
+
+  for (; atoms; atoms = atoms->base) {
+    if (atoms->slots
+        && (atom = xml__atoms_slot(atoms, hash, name, namesize)->atom))
+      return atom;
+  }
+
+  return 0;
+}
+
+/*!
+ * @brief grow table, doc is NULL for registered tables
+ */
+XML_INLINE
+bool
+xml__atoms_grow(xml_doc_t   * __restrict doc,
+                xml_atoms_t * __restrict atoms) {
+  xml_atom_slot_t *old, *slots, *slot;
+  uint32_t         oldcap, cap, i, j;
+
+  old    = atoms->slots;
+  oldcap = old ? atoms->mask + 1 : 0;
+  cap    = old ? oldcap * 2 : 16;
+
+  slots = doc ? xml__impl_calloc(doc, cap * sizeof(*slots))
+              : calloc(cap, sizeof(*slots));
+  if (!slots)
+    return false;
+
+  for (i = 0; i < oldcap; i++) {
+    if (!old[i].atom)
+      continue;
+
+    j = (uint32_t)xml__hash_name(old[i].name, old[i].namesize) & (cap - 1);
+    while ((slot = &slots[j])->atom)
+      j = (j + 1) & (cap - 1);
+
+    *slot = old[i];
+  }
+
+  if (!doc)
+    free(old);
+
+  atoms->slots = slots;
+  atoms->mask  = cap - 1;
+
+  return true;
+}
+
+/*!
+ * @brief add a name which is not in table
+ *
+ * @return atom or 0 if allocation fails
+ */
+XML_INLINE
+uint32_t
+xml__atoms_insert(xml_doc_t   * __restrict doc,
+                  xml_atoms_t * __restrict atoms,
+                  uint64_t                 hash,
+                  const char  * __restrict name,
+                  size_t                   namesize) {
+  xml_atom_slot_t *slot;
+
+  if ((!atoms->slots || (atoms->count + 1) * 2 > atoms->mask + 1)
+      && !xml__atoms_grow(doc, atoms))
+    return 0;
+
+  slot           = xml__atoms_slot(atoms, hash, name, namesize);
+  slot->name     = name;
+  slot->namesize = (uint32_t)namesize;
+  slot->atom     = atoms->next++;
+  atoms->count++;
+
+  return slot->atom;
+}
+
+/*!
+ * @brief atom of tag or prefix while parsing, name is added if it is new
+ *
+ * @return atom or 0 if allocation fails
+ */
+XML_INLINE
+uint32_t
+xml__atom_intern(xml_doc_t  * __restrict doc,
+                 const char * __restrict name,
+                 size_t                  namesize) {
+  xml__atoms_doc_t *table;
+  xml_atom_slot_t  *cached;
+  uint64_t          hash;
+  uint32_t          atom;
+
+  if (!(table = (xml__atoms_doc_t *)doc->atoms)) {
+    if (!(table = xml__impl_calloc(doc, sizeof(*table))))
+      return 0;
+
+    table->atoms.base = doc->atombase;
+    table->atoms.next = doc->atombase ? doc->atombase->next : 1;
+    doc->atoms        = &table->atoms;
+  }
+
+  cached = &table->cache[((uint8_t)name[0] ^ (namesize << 2))
+                         & (XML__ATOM_CACHE - 1)];
+  if (cached->atom
+      && (size_t)cached->namesize == namesize
+      && xml__bytes_eq(cached->name, name, namesize))
+    return cached->atom;
+
+  hash = xml__hash_name(name, namesize);
+  if (!(atom = xml__atoms_find(&table->atoms, hash, name, namesize))
+      && !(atom = xml__atoms_insert(doc, &table->atoms, hash, name, namesize)))
+    return 0;
+
+  cached->name     = name;
+  cached->namesize = (uint32_t)namesize;
+  cached->atom     = atom;
+
+  return atom;
+}
+
+/*!
+ * @brief intern tags and prefixes of nodes and their subtrees
+ *
+ * it is used for subtrees which are parsed without XML_ATOMS e.g. pieces of
+ * xml_parse_parallel(), siblings after obj are visited too.
+ *
+ * @return false if allocation fails
+ */
+XML_INLINE
+bool
+xml__atoms_tree(xml_doc_t * __restrict doc, xml_t * __restrict obj) {
+  xml_t *top;
+
+  if (!obj)
+    return true;
+
+  top = obj->parent;
+  while (obj) {
+    if (obj->type == XML_ELEMENT) {
+      if (!(obj->atom = xml__atom_intern(doc, obj->tag, obj->tagsize))
+          || (obj->prefix
+              && !xml__atom_intern(doc, obj->prefix, obj->prefixsize)))
+        return false;
+
+      if (obj->val) {
+        obj = obj->val;
+        continue;
+      }
+    }
+
+    while (!obj->next && obj->parent != top)
+      obj = obj->parent;
+
+    obj = obj->next;
+  }
+
+  return true;
+}
+
+XML_INLINE
+xml_atoms_t*
+xml_atoms_new(void) {
+  xml_atoms_t *atoms;
+
+  if (!(atoms = calloc(1, sizeof(*atoms))))
+    return NULL;
+
+  atoms->next  = 1;
+  atoms->owned = true;
+
+  return atoms;
+}
+
+XML_INLINE
+uint32_t
+xml_atoms_add(xml_atoms_t * __restrict atoms, const char * __restrict name) {
+  char     *copy;
+  size_t    namesize;
+  uint64_t  hash;
+  uint32_t  atom;
+
+  if (!atoms || !atoms->owned || !name)
+    return 0;
+
+  namesize = strlen(name);
+  hash     = xml__hash_name(name, namesize);
+
+  if ((atom = xml__atoms_find(atoms, hash, name, namesize)))
+    return atom;
+
+  if (!(copy = malloc(namesize + 1)))
+    return 0;
+
+  memcpy(copy, name, namesize + 1);
+
+  if (!(atom = xml__atoms_insert(NULL, atoms, hash, copy, namesize)))
+    free(copy);
+
+  return atom;
+}
+
+XML_INLINE
+void
+xml_atoms_free(xml_atoms_t * __restrict atoms) {
+  uint32_t i;
+
+  if (!atoms || !atoms->owned)
+    return;
+
+  if (atoms->slots) {
+    for (i = 0; i <= atoms->mask; i++) {
+      if (atoms->slots[i].atom)
+        free((char *)atoms->slots[i].name);
+    }
+
+    free(atoms->slots);
+  }
+
+  free(atoms);
+}
+
+XML_INLINE
+uint32_t
+xml_atoms_find(const xml_atoms_t * __restrict atoms,
+               const char        * __restrict name,
+               size_t                         namesize) {
+  if (!atoms || !name)
+    return 0;
+
+  return xml__atoms_find(atoms,
+                         xml__hash_name(name, namesize),
+                         name,
+                         namesize);
+}
+
+XML_INLINE
+uint32_t
+xml_atom(const xml_doc_t * __restrict doc, const char * __restrict name) {
+  if (!name)
+    return 0;
+
+  return xml_atom_sz(doc, name, strlen(name));
+}
+
+XML_INLINE
+uint32_t
+xml_atom_sz(const xml_doc_t * __restrict doc,
+            const char      * __restrict name,
+            size_t                       namesize) {
+  if (!doc)
+    return 0;
+
+  return xml_atoms_find(doc->atoms ? doc->atoms : doc->atombase,
+                        name,
+                        namesize);
+}
+
+XML_INLINE
+uint32_t
+xml_prefix_atom(const xml_doc_t * __restrict doc,
+                const xml_t     * __restrict object) {
+  if (!object || !object->prefix)
+    return 0;
+
+  return xml_atom_sz(doc, object->prefix, object->prefixsize);
+}
+
+#endif /* xml_impl_atom_h */
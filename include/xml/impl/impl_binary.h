@@ -0,0 +1,593 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_binary_h
+#define xml_impl_binary_h
+
+#include "../binary.h"
+
+#if defined(_WIN32)
+#  include <io.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+/*!
+ * @brief next node of subtree of root in depth-first order or NULL
+ */
+XML_INLINE
+const xml_t*
+xml__bin_walk(const xml_t * __restrict root, const xml_t * __restrict obj) {
+  if (obj->type == XML_ELEMENT && obj->val)
+    return obj->val;
+
+  for (; obj != root; obj = obj->parent) {
+    if (obj->next)
+      return obj->next;
+  }
+
+  return NULL;
+}
+
+XML_INLINE
+uint8_t
+xml__bin_flags(bool entity, bool decoded) {
+  return (uint8_t)((entity ? XML_BIN_ENTITY : 0)
+                   | (decoded ? XML_BIN_DECODED : 0));
+}
+
+/*!
+ * @brief fill node and attribute records, strings are laid out in same order
+ *        as they are written by xml__bin_strings()
+ */
+XML_STATIC
+void
+xml__bin_records(const xml_t    * __restrict root,
+                 xml_bin_node_t * __restrict nodes,
+                 xml_bin_attr_t * __restrict attrs) {
+  const xml_t      *obj;
+  const xml_attr_t *attr;
+  xml_bin_node_t   *n;
+  xml_bin_attr_t   *a;
+  uint64_t          soff;
+  uint32_t          cur, acur, pidx, prev;
+
+  cur  = acur = pidx = 0;
+  soff = 0;
+  obj  = root;
+
+  for (;;) {
+    n             = &nodes[cur];
+    n->type       = (uint8_t)obj->type;
+    n->flags      = xml__bin_flags(obj->entity, obj->decoded);
+    n->parent     = pidx;
+    n->next       = 0;
+    n->attr       = acur;
+    n->nattrs     = 0;
+    n->prefixsize = 0;
+
+    if (obj->type == XML_ELEMENT) {
+      if (obj->prefix) {
+        n->prefixsize = obj->prefixsize;
+        soff         += obj->prefixsize + 1u;
+      }
+
+      n->str  = soff;
+      n->size = obj->tagsize;
+      soff   += obj->tagsize + 1u;
+
+      for (attr = obj->attr; attr; attr = attr->next) {
+        a            = &attrs[acur++];
+        a->name      = soff;
+        a->namesize  = attr->namesize;
+        soff        += attr->namesize + 1u;
+        a->val       = soff;
+        a->valsize   = attr->valsize;
+        soff        += attr->valsize + 1u;
+        a->namequote = attr->namequote;
+        a->valquote  = attr->valquote;
+        a->flags     = xml__bin_flags(attr->entity, attr->decoded);
+        a->reserved  = 0;
+        n->nattrs++;
+      }
+    } else {
+      n->str  = soff;
+      n->size = obj->valsize;
+      soff   += (uint64_t)obj->valsize + 1u;
+    }
+
+    /* while parent is open, its next holds index of its last child */
+    if (cur) {
+      if ((prev = nodes[pidx].next))
+        nodes[prev].next = cur;
+      nodes[pidx].next = cur;
+    }
+
+    cur++;
+
+    if (obj->type == XML_ELEMENT && obj->val) {
+      pidx = cur - 1;
+      obj  = obj->val;
+      continue;
+    }
+
+    for (;;) {
+      if (obj == root)
+        return;
+
+      if (obj->next) {
+        obj = obj->next;
+        break;
+      }
+
+      obj              = obj->parent;
+      nodes[pidx].next = 0;
+      pidx             = nodes[pidx].parent;
+    }
+  }
+}
+
+XML_INLINE
+bool
+xml__bin_strings(xml_writer_t * __restrict w, const xml_t * __restrict root) {
+  const xml_t      *obj;
+  const xml_attr_t *attr;
+
+  for (obj = root; obj; obj = xml__bin_walk(root, obj)) {
+    if (obj->type != XML_ELEMENT) {
+      if (!xml__writer_span(w, obj->val, obj->valsize)
+          || !xml_write(w, "", 1))
+        return false;
+      continue;
+    }
+
+    if (obj->prefix
+        && (!xml_write(w, obj->prefix, obj->prefixsize)
+            || !xml_write(w, ":", 1)))
+      return false;
+
+    if (!xml_write(w, obj->tag, obj->tagsize) || !xml_write(w, "", 1))
+      return false;
+
+    for (attr = obj->attr; attr; attr = attr->next) {
+      if (!xml_write(w, attr->name, attr->namesize)
+          || !xml_write(w, "", 1)
+          || !xml__writer_span(w, attr->val, attr->valsize)
+          || !xml_write(w, "", 1))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+XML_INLINE
+bool
+xml_bin_write(xml_writer_t * __restrict w, const xml_t * __restrict root) {
+  xml_bin_header_t  h;
+  xml_bin_node_t   *nodes;
+  xml_bin_attr_t   *attrs;
+  const xml_t      *obj;
+  const xml_attr_t *attr;
+  uint64_t          nnodes, nattrs, strsize;
+  bool              ok;
+
+  if (!w || w->failed || !root || root->type != XML_ELEMENT)
+    return false;
+
+  nnodes = nattrs = strsize = 0;
+  for (obj = root; obj; obj = xml__bin_walk(root, obj)) {
+    nnodes++;
+
+    if (obj->type != XML_ELEMENT) {
+      strsize += (uint64_t)obj->valsize + 1u;
+      continue;
+    }
+
+    strsize += (obj->prefix ? obj->prefixsize + 1u : 0) + obj->tagsize + 1u;
+    for (attr = obj->attr; attr; attr = attr->next) {
+      nattrs++;
+      strsize += attr->namesize + attr->valsize + 2u;
+    }
+  }
+
+  if (nnodes >= UINT32_MAX || nattrs >= UINT32_MAX)
+    return false;
+
+  attrs = NULL;
+  if (!(nodes = malloc((size_t)nnodes * sizeof(*nodes)))
+      || (nattrs && !(attrs = malloc((size_t)nattrs * sizeof(*attrs))))) {
+    free(nodes);
+    return false;
+  }
+
+  xml__bin_records(root, nodes, attrs);
+
+  memcpy(h.magic, "XMLB", 4);
+  h.version  = XML_BIN_VERSION;
+  h.order    = XML_BIN_ORDER;
+  h.nodesize = sizeof(xml_bin_node_t);
+  h.attrsize = sizeof(xml_bin_attr_t);
+  h.reserved = 0;
+  h.nnodes   = nnodes;
+  h.nattrs   = nattrs;
+  h.strings  = sizeof(h) + nnodes * sizeof(*nodes) + nattrs * sizeof(*attrs);
+  h.strsize  = strsize;
+  h.size     = h.strings + strsize;
+
+  /* records are referenced by fd sink, they are freed after flush */
+  ok = xml_write(w, (const char *)&h, sizeof(h))
+       && xml__writer_span(w, (const char *)nodes,
+                           (size_t)nnodes * sizeof(*nodes))
+       && xml__writer_span(w, (const char *)attrs,
+                           (size_t)nattrs * sizeof(*attrs))
+       && xml__bin_strings(w, root)
+       && xml_writer_flush(w);
+
+  free(nodes);
+  free(attrs);
+
+  return ok;
+}
+
+XML_INLINE
+bool
+xml_doc_save_binary(const xml_doc_t * __restrict doc,
+                    const char      * __restrict path) {
+  xml_writer_t w;
+  int          fd;
+  bool         ok;
+
+  if (!doc || !doc->root || !path)
+    return false;
+
+#if defined(_WIN32)
+  fd = _open(path,
+             _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+             _S_IREAD | _S_IWRITE);
+#else
+  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+  if (fd < 0)
+    return false;
+
+  ok = xml_writer_fd(&w, fd) && xml_bin_write(&w, doc->root);
+  xml_writer_free(&w);
+
+#if defined(_WIN32)
+  ok = _close(fd) == 0 && ok;
+#else
+  ok = close(fd) == 0 && ok;
+#endif
+
+  return ok;
+}
+
+/*!
+ * @brief check records of image in one pass, see xml_bin_open()
+ *
+ * node i must have its parent before it and its next sibling after it, so
+ * walks which follow next / parent always end. Strings are followed by '\0'
+ * so each string must end before strsize.
+ */
+XML_STATIC
+bool
+xml__bin_check(const xml_bin_t * __restrict bin, uint64_t strsize) {
+  const xml_bin_node_t *n;
+  const xml_bin_attr_t *a;
+  uint32_t              i;
+
+  for (i = 0; i < bin->nnodes; i++) {
+    n = &bin->nodes[i];
+
+    if (n->type < XML_ELEMENT
+        || n->type > XML_COMMENT
+        || n->str >= strsize
+        || n->size >= strsize - n->str
+        || n->attr > bin->nattrs
+        || n->nattrs > bin->nattrs - n->attr
+        || (n->next && (n->next <= i
+                        || n->next >= bin->nnodes
+                        || bin->nodes[n->next].parent != n->parent)))
+      return false;
+
+    if (n->type == XML_ELEMENT) {
+      if (n->prefixsize && (uint64_t)n->prefixsize + 1u > n->str)
+        return false;
+    } else if (n->nattrs || !i) {
+      return false;
+    }
+
+    /* root is its own parent, others are under an element before them */
+    if (i && (n->parent >= i || bin->nodes[n->parent].type != XML_ELEMENT))
+      return false;
+  }
+
+  if (bin->nodes[0].parent || bin->nodes[0].next)
+    return false;
+
+  for (i = 0; i < bin->nattrs; i++) {
+    a = &bin->attrs[i];
+
+    if (a->name >= strsize
+        || a->namesize >= strsize - a->name
+        || a->val >= strsize
+        || a->valsize >= strsize - a->val)
+      return false;
+  }
+
+  return true;
+}
+
+XML_INLINE
+bool
+xml_bin_open(xml_bin_t * __restrict bin, const void * __restrict data,
+             size_t size) {
+  const xml_bin_header_t *h;
+  const char             *p;
+
+  if (!bin || !data || size < sizeof(*h) || ((uintptr_t)data & 7))
+    return false;
+
+  h = data;
+  p = data;
+
+  /* counts are checked first, so offsets below can't overflow */
+  if (memcmp(h->magic, "XMLB", 4) != 0
+      || h->version  != XML_BIN_VERSION
+      || h->order    != XML_BIN_ORDER
+      || h->nodesize != sizeof(xml_bin_node_t)
+      || h->attrsize != sizeof(xml_bin_attr_t)
+      || h->size     != size
+      || h->nnodes == 0
+      || h->nnodes >= UINT32_MAX
+      || h->nattrs >= UINT32_MAX
+      || h->strings != sizeof(*h)
+                       + h->nnodes * sizeof(xml_bin_node_t)
+                       + h->nattrs * sizeof(xml_bin_attr_t)
+      || h->strings > size
+      || size - h->strings != h->strsize
+      || h->strsize == 0
+      || p[size - 1] != '\0')
+    return false;
+
+  bin->nodes   = (const xml_bin_node_t *)(p + sizeof(*h));
+  bin->attrs   = (const xml_bin_attr_t *)(bin->nodes + h->nnodes);
+  bin->strings = p + h->strings;
+  bin->nnodes  = (uint32_t)h->nnodes;
+  bin->nattrs  = (uint32_t)h->nattrs;
+  bin->map     = NULL;
+  bin->mapsize = 0;
+
+  return xml__bin_check(bin, h->strsize);
+}
+
+XML_INLINE
+xml_bin_t*
+xml_doc_load_binary(const char * __restrict path) {
+  xml_bin_t *bin;
+  void      *map;
+  size_t     size;
+
+  if (!path || !(map = xml__file_map(path, &size)))
+    return NULL;
+
+#if !defined(_WIN32) && defined(POSIX_MADV_NORMAL)
+  /* nodes are visited randomly, not once from begin to end */
+  posix_madvise(map, size, POSIX_MADV_NORMAL);
+#endif
+
+  if (!(bin = malloc(sizeof(*bin))) || !xml_bin_open(bin, map, size)) {
+    free(bin);
+    xml__file_unmap(map, size);
+    return NULL;
+  }
+
+  bin->map     = map;
+  bin->mapsize = size;
+
+  return bin;
+}
+
+XML_INLINE
+void
+xml_bin_free(xml_bin_t * __restrict bin) {
+  if (!bin)
+    return;
+
+  if (bin->map)
+    xml__file_unmap(bin->map, bin->mapsize);
+
+  free(bin);
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_root(const xml_bin_t * __restrict bin) {
+  return bin && bin->nnodes ? bin->nodes : NULL;
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_parent(const xml_bin_t      * __restrict bin,
+               const xml_bin_node_t * __restrict node) {
+  if (!node || node == bin->nodes)
+    return NULL;
+
+  return bin->nodes + node->parent;
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_child(const xml_bin_t      * __restrict bin,
+              const xml_bin_node_t * __restrict node) {
+  uint32_t i;
+
+  if (!node || node->type != XML_ELEMENT)
+    return NULL;
+
+  i = (uint32_t)(node - bin->nodes);
+  if (i + 1 >= bin->nnodes || bin->nodes[i + 1].parent != i)
+    return NULL;
+
+  return node + 1;
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_next(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node) {
+  if (!node || !node->next)
+    return NULL;
+
+  return bin->nodes + node->next;
+}
+
+XML_INLINE
+const char*
+xml_bin_str(const xml_bin_t      * __restrict bin,
+            const xml_bin_node_t * __restrict node) {
+  return bin->strings + node->str;
+}
+
+XML_INLINE
+const char*
+xml_bin_prefix(const xml_bin_t      * __restrict bin,
+               const xml_bin_node_t * __restrict node) {
+  if (node->type != XML_ELEMENT || !node->prefixsize)
+    return NULL;
+
+  return bin->strings + node->str - node->prefixsize - 1;
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml__bin_elem_from(const xml_bin_t      * __restrict bin,
+                   const xml_bin_node_t * __restrict iter,
+                   const char           * __restrict name,
+                   size_t                            namesize) {
+  for (; iter; iter = xml_bin_next(bin, iter)) {
+    if (iter->type == XML_ELEMENT
+        && (size_t)iter->size == namesize
+        && xml__bytes_eq(bin->strings + iter->str, name, namesize))
+      return iter;
+  }
+
+  return NULL;
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem_sz(const xml_bin_t      * __restrict bin,
+                const xml_bin_node_t * __restrict node,
+                const char           * __restrict name,
+                size_t                            namesize) {
+  if (!name)
+    return NULL;
+
+  return xml__bin_elem_from(bin, xml_bin_child(bin, node), name, namesize);
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node,
+             const char           * __restrict name) {
+  if (!name)
+    return NULL;
+
+  return xml_bin_elem_sz(bin, node, name, strlen(name));
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem_next_sz(const xml_bin_t      * __restrict bin,
+                     const xml_bin_node_t * __restrict current,
+                     const char           * __restrict name,
+                     size_t                            namesize) {
+  if (!name)
+    return NULL;
+
+  return xml__bin_elem_from(bin, xml_bin_next(bin, current), name, namesize);
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_elem_next(const xml_bin_t      * __restrict bin,
+                  const xml_bin_node_t * __restrict current,
+                  const char           * __restrict name) {
+  if (!name)
+    return NULL;
+
+  return xml_bin_elem_next_sz(bin, current, name, strlen(name));
+}
+
+XML_INLINE
+const xml_bin_attr_t*
+xml_bin_attr_sz(const xml_bin_t      * __restrict bin,
+                const xml_bin_node_t * __restrict node,
+                const char           * __restrict name,
+                size_t                            namesize) {
+  const xml_bin_attr_t *a, *end;
+
+  if (!node || !name || node->type != XML_ELEMENT)
+    return NULL;
+
+  a   = bin->attrs + node->attr;
+  end = a + node->nattrs;
+  for (; a < end; a++) {
+    if ((size_t)a->namesize == namesize
+        && xml__bytes_eq(bin->strings + a->name, name, namesize))
+      return a;
+  }
+
+  return NULL;
+}
+
+XML_INLINE
+const xml_bin_attr_t*
+xml_bin_attr(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node,
+             const char           * __restrict name) {
+  if (!name)
+    return NULL;
+
+  return xml_bin_attr_sz(bin, node, name, strlen(name));
+}
+
+XML_INLINE
+const char*
+xml_bin_attr_name(const xml_bin_t      * __restrict bin,
+                  const xml_bin_attr_t * __restrict attr) {
+  return bin->strings + attr->name;
+}
+
+XML_INLINE
+const char*
+xml_bin_attr_val(const xml_bin_t      * __restrict bin,
+                 const xml_bin_attr_t * __restrict attr) {
+  return bin->strings + attr->val;
+}
+
+XML_INLINE
+const xml_bin_node_t*
+xml_bin_text(const xml_bin_t      * __restrict bin,
+             const xml_bin_node_t * __restrict node) {
+  const xml_bin_node_t *iter;
+
+  for (iter = xml_bin_child(bin, node); iter; iter = xml_bin_next(bin, iter)) {
+    if (iter->type == XML_STRING)
+      return iter;
+  }
+
+  return NULL;
+}
+
+#endif /* xml_impl_binary_h */
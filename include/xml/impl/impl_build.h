@@ -0,0 +1,238 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_build_h
+#define xml_impl_build_h
+
+#include "../build.h"
+
+/*!
+ * @brief string of new node, it is copied into document memory if requested
+ */
+XML_INLINE
+const char*
+xml__build_str(xml_doc_t  * __restrict doc,
+               const char * __restrict str,
+               size_t                  len,
+               int                     flags) {
+  char *copy;
+
+  if (!(flags & XML_BUILD_COPY))
+    return str;
+
+  /* keep node allocations aligned after copied bytes */
+  if (!(copy = xml__impl_alloc(doc, (len + 8) & ~(size_t)7)))
+    return NULL;
+
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+
+  return copy;
+}
+
+/*!
+ * @brief link obj as last child of parent in list order
+ *
+ * children don't have a tail pointer, last node which is added by builder is
+ * used as a hint: if tree is built in document order, its ancestor under
+ * parent is the last child, otherwise list is walked.
+ */
+XML_INLINE
+void
+xml__build_link(xml_doc_t * __restrict doc,
+                xml_t     * __restrict parent,
+                xml_t     * __restrict obj) {
+  xml_lookup_t *lookup;
+  xml_t        *last;
+
+  obj->parent = parent;
+
+  if (parent->reverse || !parent->val) {
+    obj->next   = parent->val;
+    parent->val = obj;
+  } else {
+    for (last = doc->last; last && last->parent != parent; last = last->parent);
+
+    if (!last || last->next)
+      for (last = parent->val; last->next; last = last->next);
+
+    last->next = obj;
+  }
+
+  /* first child by tag and links to next same tag would miss obj */
+  if (obj->type == XML_ELEMENT
+      && parent->indexed
+      && (lookup = xml__lookup_map(doc, parent)))
+    lookup->elems = NULL;
+
+  doc->last = obj;
+  xml_touch(obj);
+}
+
+XML_INLINE
+xml_t*
+xml_elem_append(xml_doc_t  * __restrict doc,
+                xml_t      * __restrict parent,
+                const char * __restrict tag,
+                int                     flags) {
+  xml_t      *obj;
+  const char *name, *colon;
+  size_t      len;
+
+  if (!doc || !tag
+      || (parent ? parent->type != XML_ELEMENT : doc->root != NULL)
+      || (len = strlen(tag)) > UINT16_MAX
+      || !(name = xml__build_str(doc, tag, len, flags))
+      || !(obj = parent
+                   ? xml__impl_calloc(doc, sizeof(xml_t))
+                   : xml__root_calloc(doc)))
+    return NULL;
+
+  obj->type     = XML_ELEMENT;
+  obj->readonly = doc->readonly;
+  obj->reverse  = doc->reverse;
+  obj->tag      = name;
+  obj->tagsize  = (uint16_t)len;
+
+  if (doc->sepPrefixes && (colon = memchr(name, ':', len))) {
+    obj->prefix     = name;
+    obj->prefixsize = (uint16_t)(colon - name);
+    obj->tag        = colon + 1;
+    obj->tagsize    = (uint16_t)(len - obj->prefixsize - 1);
+  }
+
+  if ((doc->intern || doc->atoms)
+      && (!(obj->atom = xml__atom_intern(doc, obj->tag, obj->tagsize))
+          || (obj->prefix
+              && !xml__atom_intern(doc, obj->prefix, obj->prefixsize))))
+    return NULL;
+
+  if (!parent) {
+    doc->root = obj;
+    doc->last = obj;
+    xml_touch(obj);
+    return obj;
+  }
+
+  xml__build_link(doc, parent, obj);
+  return obj;
+}
+
+XML_INLINE
+xml_attr_t*
+xml_attr_set_sz(xml_doc_t  * __restrict doc,
+                xml_t      * __restrict elem,
+                const char * __restrict name,
+                const char * __restrict val,
+                size_t                  valsize,
+                int                     flags) {
+  xml_lookup_t *lookup;
+  xml_attr_t   *attr, *last;
+  const char   *str;
+  size_t        namesize;
+  int           valflags;
+
+  if (!doc || !elem || !name || !val
+      || elem->type != XML_ELEMENT
+      || (namesize = strlen(name)) > UINT16_MAX
+      || valsize > UINT16_MAX)
+    return NULL;
+
+  last = NULL;
+  for (attr = elem->attr; attr; attr = attr->next) {
+    if ((size_t)attr->namesize == namesize
+        && xml__bytes_eq(attr->name, name, namesize))
+      break;
+    last = attr;
+  }
+
+  /*
+   * entities of attributes are decoded in place unless document is readonly,
+   * don't let it write into referenced memory (e.g. a string literal)
+   */
+  valflags = flags;
+  if ((flags & XML_BUILD_RAW)
+      && !doc->readonly
+      && memchr(val, '&', valsize))
+    valflags |= XML_BUILD_COPY;
+
+  if (!(str = xml__build_str(doc, val, valsize, valflags)))
+    return NULL;
+
+  if (!attr) {
+    if (!(attr = xml__impl_calloc(doc, sizeof(xml_attr_t)))
+        || !(attr->name = xml__build_str(doc, name, namesize, flags)))
+      return NULL;
+
+    attr->namesize = (uint16_t)namesize;
+    attr->valquote = '"';
+
+    if (elem->reverse || !last) {
+      attr->next = elem->attr;
+      elem->attr = attr;
+    } else {
+      last->next = attr;
+    }
+
+    /* table of attributes would miss new one */
+    if (elem->indexed && (lookup = xml__lookup_map(doc, elem)))
+      lookup->attrs = NULL;
+  }
+
+  attr->val     = str;
+  attr->valsize = (uint16_t)valsize;
+  attr->entity  = (flags & XML_BUILD_RAW) && memchr(str, '&', valsize);
+  attr->decoded = !(flags & XML_BUILD_RAW);
+
+  xml_touch(elem);
+  return attr;
+}
+
+XML_INLINE
+xml_attr_t*
+xml_attr_set(xml_doc_t  * __restrict doc,
+             xml_t      * __restrict elem,
+             const char * __restrict name,
+             const char * __restrict val,
+             int                     flags) {
+  if (!val)
+    return NULL;
+
+  return xml_attr_set_sz(doc, elem, name, val, strlen(val), flags);
+}
+
+XML_INLINE
+xml_t*
+xml_text_append(xml_doc_t  * __restrict doc,
+                xml_t      * __restrict parent,
+                const char * __restrict text,
+                size_t                  len,
+                int                     flags) {
+  xml_t      *obj;
+  const char *str;
+
+  if (!doc || !parent || !text
+      || parent->type != XML_ELEMENT
+      || len > UINT32_MAX
+      || !(str = xml__build_str(doc, text, len, flags))
+      || !(obj = xml__impl_calloc(doc, sizeof(xml_t))))
+    return NULL;
+
+  /* referenced text can't be decoded in place */
+  obj->type     = XML_STRING;
+  obj->readonly = doc->readonly || !(flags & XML_BUILD_COPY);
+  obj->reverse  = doc->reverse;
+  obj->val      = (void *)str;
+  obj->valsize  = (uint32_t)len;
+  obj->entity   = (flags & XML_BUILD_RAW) && memchr(str, '&', len);
+  obj->decoded  = !(flags & XML_BUILD_RAW);
+
+  xml__build_link(doc, parent, obj);
+  return obj;
+}
+
+#endif /* xml_impl_build_h */
@@ -11,19 +11,98 @@
 #include "../xml.h"
 #include "impl_mem.h"
 
+XML_INLINE
+xml_doc_t*
+xml_doc_new(const xml_allocator_t * __restrict allocator) {
+  xml_doc_t       *doc;
+  xml_allocator_t  alloc;
+
+  if (allocator && allocator->alloc && allocator->free) {
+    alloc = *allocator;
+  } else {
+    alloc.alloc = xml__default_alloc;
+    alloc.free  = xml__default_free;
+    alloc.ctx   = NULL;
+  }
+
+  if (!(doc = alloc.alloc(alloc.ctx, sizeof(*doc))))
+    return NULL;
+
+  memset(doc, 0, sizeof(*doc));
+  doc->allocator = alloc;
+
+  if (!xml__mem_page(doc, XML_MEM_PAGE)) {
+    alloc.free(alloc.ctx, doc);
+    return NULL;
+  }
+
+  return doc;
+}
+
 XML_INLINE
 void
-xml_free(xml_doc_t * __restrict doc) {
-  xml_mem_t *mem, *tofree;
+xml_doc_reset(xml_doc_t * __restrict doc) {
+  xml_mem_t *mem, *next;
+
+  if (!doc)
+    return;
+
+  if (doc->map && doc->unmap)
+    doc->unmap(doc->map, doc->mapsize);
+
+  /* keep current page, move others to spare list */
+  mem       = doc->memroot;
+  mem->size = 0;
+  next      = mem->next;
+  mem->next = NULL;
+
+  while (next) {
+    mem           = next;
+    next          = mem->next;
+    mem->next     = doc->memspare;
+    doc->memspare = mem;
+  }
+
+  doc->root    = NULL;
+  doc->ptr     = NULL;
+  doc->map     = NULL;
+  doc->mapsize = 0;
+  doc->unmap   = NULL;
+  doc->atoms   = NULL;
+  doc->last    = NULL;
+
+  doc->lookups    = NULL;
+  doc->lookupmask = 0;
+  doc->nlookups   = 0;
+
+  memset(&doc->prescan, 0, sizeof(doc->prescan));
+  memset(&doc->error,   0, sizeof(doc->error));
+}
 
-  mem = doc->memroot;
-  while (mem) {
-    tofree = mem;
-    mem    = mem->next;
-    free(tofree);
+XML_INLINE
+const char*
+xml_error_str(xml_error_code_t code) {
+  switch (code) {
+    case XML_OK:           return "no error";
+    case XML_ERR_EOF:      return "unexpected end of input";
+    case XML_ERR_SYNTAX:   return "unexpected character";
+    case XML_ERR_END_TAG:  return "end tag doesn't match";
+    case XML_ERR_ATTR:     return "malformed attribute";
+    case XML_ERR_UNCLOSED: return "element is not closed";
+    case XML_ERR_NOMEM:    return "out of memory";
+    default:               return "unknown error";
   }
+}
+
+XML_INLINE
+void
+xml_free(xml_doc_t * __restrict doc) {
+  if (doc->map && doc->unmap)
+    doc->unmap(doc->map, doc->mapsize);
 
-  free(doc);
+  xml__mem_free(doc, doc->memroot);
+  xml__mem_free(doc, doc->memspare);
+  xml__free(doc, doc);
 }
 
 XML_INLINE
@@ -40,11 +119,18 @@ xml_attr_t*
 xmla_sz(const xml_t * __restrict object,
         const char  * __restrict name,
         size_t                   namesize) {
-  xml_attr_t *iter;
+  const xml_lookup_t *lookup;
+  xml_attr_t         *iter;
 
   if (!object || !name || !(iter = object->attr))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->attrs)
+    return xml__lookup_attr(lookup,
+                            xml__hash_name(name, namesize),
+                            name,
+                            namesize);
+
   while (iter
          && (!iter->name
              || (size_t)iter->namesize != namesize
@@ -60,11 +146,17 @@ xml_attr_t*
 xmla_packed4(const xml_t * __restrict object,
              uint32_t                 packed,
              size_t                   namesize) {
-  xml_attr_t *iter;
+  const xml_lookup_t *lookup;
+  xml_attr_t         *iter;
 
   if (!object || !(iter = object->attr))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->attrs)
+    return namesize <= 4
+             ? xml__lookup_attr_packed(lookup, packed, namesize)
+             : NULL;
+
   while (iter
          && (!iter->name
              || !xml__bytes_eq_packed4(iter->name,
@@ -81,11 +173,17 @@ xml_attr_t*
 xmla_packed8(const xml_t * __restrict object,
              uint64_t                 packed,
              size_t                   namesize) {
-  xml_attr_t *iter;
+  const xml_lookup_t *lookup;
+  xml_attr_t         *iter;
 
   if (!object || !(iter = object->attr))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->attrs)
+    return namesize >= 5
+             ? xml__lookup_attr_packed(lookup, packed, namesize)
+             : NULL;
+
   while (iter
          && (!iter->name
              || !xml__bytes_eq_packed8(iter->name,
@@ -102,11 +200,15 @@ xml_attr_t*
 xmla_packed(const xml_t * __restrict object,
             uint64_t                 packed,
             size_t                   namesize) {
-  xml_attr_t *iter;
+  const xml_lookup_t *lookup;
+  xml_attr_t         *iter;
 
   if (!object || !(iter = object->attr))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->attrs)
+    return xml__lookup_attr_packed(lookup, packed, namesize);
+
   while (iter
          && (!iter->name
              || !xml__bytes_eq_packed(iter->name,
@@ -132,11 +234,18 @@ xml_t*
 xml_elem_sz(const xml_t * __restrict object,
             const char  * __restrict name,
             size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
   
   if (!object || !name || object->type != XML_ELEMENT || !(iter = object->val))
     return NULL;
   
+  if ((lookup = xml__lookup_find(object)) && lookup->elems)
+    return xml__lookup_elem(lookup,
+                            xml__hash_name(name, namesize),
+                            name,
+                            namesize);
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -153,11 +262,17 @@ xml_t*
 xml_elem_packed4(const xml_t * __restrict object,
                  uint32_t                 packed,
                  size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!object || object->type != XML_ELEMENT || !(iter = object->val))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->elems)
+    return namesize <= 4
+             ? xml__lookup_elem_packed(lookup, packed, namesize)
+             : NULL;
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -175,11 +290,17 @@ xml_t*
 xml_elem_packed8(const xml_t * __restrict object,
                  uint64_t                 packed,
                  size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!object || object->type != XML_ELEMENT || !(iter = object->val))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->elems)
+    return namesize >= 5
+             ? xml__lookup_elem_packed(lookup, packed, namesize)
+             : NULL;
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -197,11 +318,15 @@ xml_t*
 xml_elem_packed(const xml_t * __restrict object,
                 uint64_t                 packed,
                 size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!object || object->type != XML_ELEMENT || !(iter = object->val))
     return NULL;
 
+  if ((lookup = xml__lookup_find(object)) && lookup->elems)
+    return xml__lookup_elem_packed(lookup, packed, namesize);
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -228,11 +353,17 @@ xml_t*
 xml_elem_next_sz(const xml_t * __restrict current,
                  const char  * __restrict name,
                  size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!current || !name || !(iter = current->next))
     return NULL;
 
+  if ((lookup = xml__lookup_linked(current))
+      && (size_t)current->tagsize == namesize
+      && xml__bytes_eq(current->tag, name, namesize))
+    return lookup->nexttag;
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -249,11 +380,19 @@ xml_t*
 xml_elem_next_packed4(const xml_t * __restrict current,
                       uint32_t                 packed,
                       size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!current || !(iter = current->next))
     return NULL;
 
+  if ((lookup = xml__lookup_linked(current))
+      && xml__bytes_eq_packed4(current->tag,
+                               (size_t)current->tagsize,
+                               packed,
+                               namesize))
+    return lookup->nexttag;
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -271,11 +410,19 @@ xml_t*
 xml_elem_next_packed8(const xml_t * __restrict current,
                       uint64_t                 packed,
                       size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!current || !(iter = current->next))
     return NULL;
 
+  if ((lookup = xml__lookup_linked(current))
+      && xml__bytes_eq_packed8(current->tag,
+                               (size_t)current->tagsize,
+                               packed,
+                               namesize))
+    return lookup->nexttag;
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -293,11 +440,19 @@ xml_t*
 xml_elem_next_packed(const xml_t * __restrict current,
                      uint64_t                 packed,
                      size_t                   namesize) {
-  xml_t *iter;
+  const xml_lookup_t *lookup;
+  xml_t              *iter;
 
   if (!current || !(iter = current->next))
     return NULL;
 
+  if ((lookup = xml__lookup_linked(current))
+      && xml__bytes_eq_packed(current->tag,
+                              (size_t)current->tagsize,
+                              packed,
+                              namesize))
+    return lookup->nexttag;
+
   while (iter
          && (iter->type != XML_ELEMENT
              || !iter->tag
@@ -310,4 +465,119 @@ xml_elem_next_packed(const xml_t * __restrict current,
   return iter;
 }
 
+/*!
+ * @brief end of exact element in contents, after '>' of its end tag
+ *
+ * end is not stored: in exact parent it is begin of next sibling, else
+ * source of exact element has only spaces and end tags after its last child,
+ * so end is found after deepest last child (or last attribute), one '>' per
+ * end tag. Relocated (decoded) values are not in contents, NULL is returned
+ * then.
+ */
+XML_INLINE
+const char*
+xml__src_end(const xml_t * __restrict object) {
+  const xml_t      *last;
+  const xml_attr_t *attr;
+  const char       *p;
+  size_t            ntags;
+
+  if (!object->reverse
+      && (last = object->next)
+      && !last->dirty
+      && object->parent
+      && object->parent->exact) {
+    switch (last->type) {
+      case XML_ELEMENT:
+        return (last->prefix ? last->prefix : last->tag) - 1;
+      case XML_STRING:
+        if (!last->decoded)
+          return last->val;
+        break;
+      case XML_CDATA:
+        return (const char *)last->val - 9; /* "<![CDATA[" */
+      case XML_COMMENT:
+        return (const char *)last->val - 4; /* "<!--"      */
+      default:
+        break;
+    }
+  }
+
+  ntags = 0;
+  while ((last = object->val)) {
+    if (!object->reverse)
+      for (; last->next; last = last->next);
+
+    ntags++;
+    if (last->type != XML_ELEMENT)
+      break;
+
+    object = last;
+  }
+
+  if (last) {
+    if (last->decoded)
+      return NULL;
+
+    p = (const char *)last->val + last->valsize;
+    if (last->type != XML_STRING)
+      p += 3; /* "]]>" or "-->" */
+  } else {
+    /* empty element: <a .../> or <a ...></a> */
+    p = object->tag + object->tagsize;
+    if ((attr = object->attr)) {
+      if (!object->reverse)
+        for (; attr->next; attr = attr->next);
+
+      if (attr->decoded || !attr->valquote)
+        return NULL;
+
+      p = attr->val + attr->valsize + 1;
+    }
+
+    while (*p != '>')
+      p++;
+
+    if (p[-1] != '/')
+      ntags++;
+
+    p++;
+  }
+
+  for (; ntags > 0; ntags--) {
+    while (*p != '>')
+      p++;
+    p++;
+  }
+
+  return p;
+}
+
+XML_INLINE
+const char*
+xml_src(const xml_t * __restrict object, size_t * __restrict size) {
+  const char *begin, *end;
+
+  if (!object
+      || object->type != XML_ELEMENT
+      || !object->readonly
+      || object->dirty
+      || !object->exact
+      || !object->tag
+      || !(end = xml__src_end(object)))
+    return NULL;
+
+  begin = (object->prefix ? object->prefix : object->tag) - 1;
+  *size = (size_t)(end - begin);
+  return begin;
+}
+
+XML_INLINE
+void
+xml_touch(xml_t * __restrict object) {
+  /* ancestors of a changed node are already marked */
+  for (; object && !object->dirty; object = object->parent)
+    object->dirty = true;
+}
+
 #endif /* xml_impl_common_h */
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_entity_h
+#define xml_impl_entity_h
+
+#include "../entity.h"
+#include "impl_mem.h"
+#include "impl_scan.h"
+
+/*!
+ * @brief write code point as UTF-8
+ *
+ * @return number of bytes which are written
+ */
+XML_INLINE
+size_t
+xml__utf8(char * __restrict out, uint32_t c) {
+  if (c < 0x80) {
+    out[0] = (char)c;
+    return 1;
+  }
+
+  if (c < 0x800) {
+    out[0] = (char)(0xC0 | (c >> 6));
+    out[1] = (char)(0x80 | (c & 0x3F));
+    return 2;
+  }
+
+  if (c < 0x10000) {
+    out[0] = (char)(0xE0 | (c >> 12));
+    out[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (c & 0x3F));
+    return 3;
+  }
+
+  out[0] = (char)(0xF0 | (c >> 18));
+  out[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (c & 0x3F));
+  return 4;
+}
+
+/*!
+ * @brief parse reference at p ('&')
+ *
+ * @param[in]  p    '&'
+ * @param[in]  end  end of string
+ * @param[out] c    code point
+ * @return length of reference or 0 if it is unknown or malformed
+ */
+XML_STATIC
+size_t
+xml__entity(const char * __restrict p,
+            const char * __restrict end,
+            uint32_t   * __restrict c) {
+  const char *q;
+  uint32_t    v, d;
+  size_t      n;
+
+  n = (size_t)(end - p);
+
+  if (n >= 4 && p[3] == ';') {
+    if (p[1] == 'l' && p[2] == 't') { *c = '<'; return 4; }
+    if (p[1] == 'g' && p[2] == 't') { *c = '>'; return 4; }
+  }
+
+  if (n >= 5 && p[1] == 'a' && p[2] == 'm' && p[3] == 'p' && p[4] == ';') {
+    *c = '&';
+    return 5;
+  }
+
+  if (n >= 6 && p[5] == ';') {
+    if (xml__bytes_eq(p + 1, "quot", 4)) { *c = '"';  return 6; }
+    if (xml__bytes_eq(p + 1, "apos", 4)) { *c = '\''; return 6; }
+  }
+
+  if (n < 4 || p[1] != '#')
+    return 0;
+
+  v = 0;
+  q = p + 2;
+
+  if (*q == 'x') {
+    for (q++; q < end && *q != ';'; q++) {
+      if (*q >= '0' && *q <= '9')      d = (uint32_t)(*q - '0');
+      else if (*q >= 'a' && *q <= 'f') d = (uint32_t)(*q - 'a' + 10);
+      else if (*q >= 'A' && *q <= 'F') d = (uint32_t)(*q - 'A' + 10);
+      else                             return 0;
+
+      if ((v = v * 16 + d) > 0x10FFFF)
+        return 0;
+    }
+
+    if (q - p < 4)
+      return 0;
+  } else {
+    for (; q < end && *q != ';'; q++) {
+      if (*q < '0' || *q > '9')
+        return 0;
+
+      if ((v = v * 10 + (uint32_t)(*q - '0')) > 0x10FFFF)
+        return 0;
+    }
+
+    if (q - p < 3)
+      return 0;
+  }
+
+  /* no ';', NUL or surrogate */
+  if (q >= end || v == 0 || (v >= 0xD800 && v <= 0xDFFF))
+    return 0;
+
+  *c = v;
+  return (size_t)(q - p) + 1;
+}
+
+XML_INLINE
+size_t
+xml_decode(char * dst, const char * src, size_t len) {
+  const char *p, *q, *end;
+  char       *o;
+  uint32_t    c;
+  size_t      n;
+
+  p   = src;
+  o   = dst;
+  end = src + len;
+
+  /* runs without '&' are found with vector scanner and moved at once */
+  while ((q = xml__scan_byte(p, end, '&')) < end) {
+    if ((n = (size_t)(q - p)) > 0 && o != p)
+      memmove(o, p, n);
+
+    o += n;
+
+    /* reference is parsed before it is overwritten, it is not longer */
+    if ((n = xml__entity(q, end, &c))) {
+      o += xml__utf8(o, c);
+      p  = q + n;
+    } else {
+      *o++ = '&';
+      p    = q + 1;
+    }
+  }
+
+  if ((n = (size_t)(end - p)) > 0 && o != p)
+    memmove(o, p, n);
+
+  return (size_t)(o + n - dst);
+}
+
+/*!
+ * @brief decode string in place or into document's memory for readonly
+ *
+ * @return decoded, null terminated string or NULL if allocation fails
+ */
+XML_INLINE
+char*
+xml__decode_str(xml_doc_t  * __restrict doc,
+                const char * __restrict str,
+                size_t                  len,
+                bool                    readonly,
+                size_t     * __restrict outlen) {
+  char *dst;
+
+  if (readonly) {
+    /* keep later allocations (nodes, tables) aligned after copied bytes */
+    if (!(dst = xml__impl_alloc(doc, (len + 8) & ~(size_t)7)))
+      return NULL;
+  } else {
+    dst = (char *)str;
+  }
+
+  *outlen      = xml_decode(dst, str, len);
+  dst[*outlen] = '\0';
+
+  return dst;
+}
+
+XML_INLINE
+const char*
+xml_val_decode(xml_doc_t * __restrict doc, xml_t * __restrict obj) {
+  char   *str;
+  size_t  len;
+
+  if (!obj || obj->type != XML_STRING)
+    return NULL;
+
+  if (!obj->entity)
+    return obj->val;
+
+  if (!(str = xml__decode_str(doc, obj->val, obj->valsize, obj->readonly,
+                              &len)))
+    return NULL;
+
+  obj->val     = str;
+  obj->valsize = (uint32_t)len;
+  obj->entity  = false;
+  obj->decoded = true;
+
+  return str;
+}
+
+XML_INLINE
+const char*
+xmla_decode(xml_doc_t * __restrict doc, xml_attr_t * __restrict attr) {
+  char   *str;
+  size_t  len;
+
+  if (!attr)
+    return NULL;
+
+  if (!attr->entity)
+    return attr->val;
+
+  if (!(str = xml__decode_str(doc, attr->val, attr->valsize, doc->readonly,
+                              &len)))
+    return NULL;
+
+  attr->val     = str;
+  attr->valsize = (uint16_t)len;
+  attr->entity  = false;
+  attr->decoded = true;
+
+  return str;
+}
+
+XML_INLINE
+void
+xml_doc_decode(xml_doc_t * __restrict doc) {
+  xml_t      *it;
+  xml_attr_t *attr;
+
+  if (!doc)
+    return;
+
+  /* depth-first without stack by following parent links */
+  it = doc->root;
+  while (it) {
+    if (it->type == XML_ELEMENT) {
+      for (attr = it->attr; attr; attr = attr->next)
+        xmla_decode(doc, attr);
+
+      if (it->val) {
+        it = it->val;
+        continue;
+      }
+    } else if (it->entity) {
+      xml_val_decode(doc, it);
+    }
+
+    while (it && !it->next)
+      it = it->parent;
+
+    if (it)
+      it = it->next;
+  }
+}
+
+#endif /* xml_impl_entity_h */
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_file_h
+#define xml_impl_file_h
+
+#include "../file.h"
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+XML_INLINE
+void
+xml__file_unmap(void *map, size_t mapsize) {
+#if defined(_WIN32)
+  (void)mapsize;
+  UnmapViewOfFile(map);
+#else
+  munmap(map, mapsize);
+#endif
+}
+
+/*!
+ * @brief map file read-only, returns NULL if it fails or file is empty
+ */
+XML_STATIC
+void*
+xml__file_map(const char * __restrict path, size_t * __restrict size) {
+#if defined(_WIN32)
+  HANDLE         file, mapping;
+  LARGE_INTEGER  fsize;
+  void          *map;
+  DWORD          flags;
+
+  /* contents are read once from begin to end */
+  flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+  file  = CreateFileA(path,
+                      GENERIC_READ,
+                      FILE_SHARE_READ,
+                      NULL,
+                      OPEN_EXISTING,
+                      flags,
+                      NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  map = NULL;
+  if (GetFileSizeEx(file, &fsize)
+      && fsize.QuadPart > 0
+      && (unsigned long long)fsize.QuadPart <= (size_t)-1) {
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) {
+      map   = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      *size = (size_t)fsize.QuadPart;
+      CloseHandle(mapping);
+    }
+  }
+
+  CloseHandle(file);
+  return map;
+#else
+  struct stat st;
+  void       *map;
+  int         fd;
+
+  if ((fd = open(path, O_RDONLY)) < 0)
+    return NULL;
+
+  map = NULL;
+  if (fstat(fd, &st) == 0
+      && st.st_size > 0
+      && (unsigned long long)st.st_size <= (size_t)-1) {
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      map = NULL;
+    } else {
+      *size = (size_t)st.st_size;
+
+      /* contents are read once from begin to end */
+#if defined(POSIX_MADV_SEQUENTIAL)
+      posix_madvise(map, *size, POSIX_MADV_SEQUENTIAL);
+#endif
+    }
+  }
+
+  close(fd);
+  return map;
+#endif
+}
+
+XML_INLINE
+xml_doc_t*
+xml_parse_file(const char * __restrict path, xml_options_t options) {
+  xml_doc_t *doc;
+  void      *map;
+  size_t     size;
+
+  if (!path || !(map = xml__file_map(path, &size)))
+    return NULL;
+
+  if (!(doc = xml_parse_n(map, size, options | XML_READONLY))) {
+    xml__file_unmap(map, size);
+    return NULL;
+  }
+
+  doc->map     = map;
+  doc->mapsize = size;
+  doc->unmap   = xml__file_unmap;
+
+  return doc;
+}
+
+#endif /* xml_impl_file_h */
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Stage 1 of parser: structural index.
+ *
+ * Input is classified in 64-byte blocks into bitmaps where each set bit marks
+ * a structural character: < > = " ' ` &. Bitmaps are flattened to a position
+ * list, parser (stage 2) doesn't look at bytes between structural characters,
+ * it jumps from one structural position to next one. '&' is indexed to flag
+ * strings which contain entity or character references without visiting
+ * their bytes again.
+ *
+ * Index is built for a fixed window (XML_INDEX_WINDOW bytes, max 65536) at a
+ * time, so it has a fixed size and it can live in stack. Blocks don't depend
+ * on each other, so windows can be built independently (e.g. in parallel).
+ */
+
+#ifndef xml_impl_index_h
+#define xml_impl_index_h
+
+#include "../common.h"
+#include "impl_scan.h"
+
+#ifndef XML_INDEX_WINDOW
+#  define XML_INDEX_WINDOW 4096
+#endif
+
+typedef struct xml__index_t {
+  const char *base;  /* start of indexed window                */
+  const char *wend;  /* end of indexed window                  */
+  const char *end;   /* end of input                           */
+  uint32_t    cur;   /* cursor in pos[]                        */
+  uint32_t    count; /* number of structural chars in window   */
+  uint16_t    pos[XML_INDEX_WINDOW]; /* offsets from base      */
+} xml__index_t;
+
+XML_INLINE
+bool
+xml__structural(char c) {
+  return c == '<' || c == '>' || c == '='
+      || c == '"' || c == '\'' || c == '`' || c == '&';
+}
+
+#if defined(XML_SIMD)
+XML_INLINE
+xml__v
+xml__vstructural(xml__v v) {
+  return xml__vor(xml__vor(xml__vor(xml__veq(v, '<'), xml__veq(v, '>')),
+                           xml__vor(xml__veq(v, '='), xml__veq(v, '"'))),
+                  xml__vor(xml__vor(xml__veq(v, '\''), xml__veq(v, '`')),
+                           xml__veq(v, '&')));
+}
+#endif
+
+/*!
+ * @brief classify 64 bytes, bit i is set if p[i] is structural
+ */
+XML_INLINE
+uint64_t
+xml__index_block(const char * __restrict p) {
+#if defined(XML_SIMD_AVX2)
+  return xml__vmask(xml__vstructural(xml__vload(p)))
+       | xml__vmask(xml__vstructural(xml__vload(p + 32))) << 32;
+#elif defined(XML_SIMD_SSE2)
+  return xml__vmask(xml__vstructural(xml__vload(p)))
+       | xml__vmask(xml__vstructural(xml__vload(p + 16))) << 16
+       | xml__vmask(xml__vstructural(xml__vload(p + 32))) << 32
+       | xml__vmask(xml__vstructural(xml__vload(p + 48))) << 48;
+#elif defined(XML_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+  static const uint8_t bit[16] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+  };
+  uint8x16_t b, t0, t1, t2, t3;
+
+  b  = vld1q_u8(bit);
+  t0 = vandq_u8(xml__vstructural(xml__vload(p)),      b);
+  t1 = vandq_u8(xml__vstructural(xml__vload(p + 16)), b);
+  t2 = vandq_u8(xml__vstructural(xml__vload(p + 32)), b);
+  t3 = vandq_u8(xml__vstructural(xml__vload(p + 48)), b);
+  t0 = vpaddq_u8(vpaddq_u8(t0, t1), vpaddq_u8(t2, t3));
+  t0 = vpaddq_u8(t0, t0);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(t0), 0);
+#else
+  uint64_t m;
+  int      i;
+
+  m = 0;
+  for (i = 0; i < 64; i++)
+    m |= (uint64_t)xml__structural(p[i]) << i;
+
+  return m;
+#endif
+}
+
+/*!
+ * @brief build index for window which starts at p
+ *
+ * bitmaps are flattened to positions, so stage 2 reads positions sequentially
+ * instead of scanning bits
+ */
+XML_STATIC
+void
+xml__index_build(xml__index_t * __restrict idx,
+                 const char   * __restrict p) {
+  const char *wend, *blk;
+  uint16_t   *pos;
+  uint64_t    m;
+  uint16_t    off;
+  int         i, rem;
+
+  wend = (size_t)(idx->end - p) > XML_INDEX_WINDOW
+           ? p + XML_INDEX_WINDOW
+           : idx->end;
+
+  idx->base = p;
+  idx->wend = wend;
+  idx->cur  = 0;
+  pos       = idx->pos;
+
+  for (blk = p; wend - blk >= 64; blk += 64) {
+    m   = xml__index_block(blk);
+    off = (uint16_t)(blk - p);
+    while (m) {
+      *pos++ = (uint16_t)(off + xml__ctz64(m));
+      m     &= m - 1;
+    }
+  }
+
+  if ((rem = (int)(wend - blk)) > 0) {
+    off = (uint16_t)(blk - p);
+    for (i = 0; i < rem; i++) {
+      if (xml__structural(blk[i]))
+        *pos++ = (uint16_t)(off + i);
+    }
+  }
+
+  idx->count = (uint32_t)(pos - idx->pos);
+}
+
+XML_INLINE
+void
+xml__index_init(xml__index_t * __restrict idx,
+                const char   * __restrict p,
+                const char   * __restrict end) {
+  idx->end = end;
+  xml__index_build(idx, p);
+}
+
+/*!
+ * @brief first structural character at or after p, returns end if none
+ */
+XML_INLINE
+const char*
+xml__index_next(xml__index_t * __restrict idx,
+                const char   * __restrict p) {
+  const char *q;
+
+  if (p < idx->base || p >= idx->wend) {
+    if (p >= idx->end)
+      return idx->end;
+    xml__index_build(idx, p);
+  }
+
+  for (;;) {
+    while (idx->cur < idx->count) {
+      if ((q = idx->base + idx->pos[idx->cur]) >= p)
+        return q;
+      idx->cur++;
+    }
+
+    if ((p = idx->wend) >= idx->end)
+      return idx->end;
+
+    xml__index_build(idx, p);
+  }
+}
+
+/*!
+ * @brief first structural character c at or after p, returns end if none
+ */
+XML_INLINE
+const char*
+xml__index_find(xml__index_t * __restrict idx,
+                const char   * __restrict p,
+                char                      c) {
+  while ((p = xml__index_next(idx, p)) < idx->end && *p != c)
+    p++;
+
+  return p;
+}
+
+/*!
+ * @brief same as xml__index_find() but it also reports '&' before c
+ *
+ * @param[in]  idx index
+ * @param[in]  p   start position
+ * @param[in]  c   structural character to find
+ * @param[out] amp set to true if there is '&' in [p, result), else untouched
+ * @return position of c or end if not found
+ */
+XML_INLINE
+const char*
+xml__index_find_amp(xml__index_t * __restrict idx,
+                    const char   * __restrict p,
+                    char                      c,
+                    bool         * __restrict amp) {
+  while ((p = xml__index_next(idx, p)) < idx->end && *p != c) {
+    if (*p == '&')
+      *amp = true;
+    p++;
+  }
+
+  return p;
+}
+
+/*!
+ * @brief closing quote which is not escaped by backslash, NULL if not found
+ *
+ * amp is set to true if quoted string contains '&', see xml__index_find_amp()
+ */
+XML_INLINE
+char*
+xml__index_quote(xml__index_t * __restrict idx,
+                 char         * __restrict p,
+                 char                      quote,
+                 bool         * __restrict amp) {
+  char *begin;
+
+  begin = p;
+  while ((p = (char *)xml__index_find_amp(idx, p, quote, amp)) < idx->end) {
+    if (!xml__quote_escaped(begin, p))
+      return p;
+    p++;
+  }
+
+  return NULL;
+}
+
+/*!
+ * @brief find '>' which is preceded by a and b e.g. "-->", "]]>", "?>"
+ *
+ * @param[in] idx   index
+ * @param[in] begin first byte that can be part of terminator
+ * @param[in] a     first char of terminator or '\0' to ignore it
+ * @param[in] b     second char of terminator
+ * @return position of '>' or NULL if not found
+ */
+XML_INLINE
+char*
+xml__index_close(xml__index_t * __restrict idx,
+                 char         * __restrict begin,
+                 char                      a,
+                 char                      b) {
+  char *p;
+
+  p = begin;
+  while ((p = (char *)xml__index_find(idx, p, '>')) < idx->end) {
+    if (p - begin >= (a ? 2 : 1) && p[-1] == b && (!a || p[-2] == a))
+      return p;
+    p++;
+  }
+
+  return NULL;
+}
+
+#endif /* xml_impl_index_h */
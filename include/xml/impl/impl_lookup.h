@@ -0,0 +1,533 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Lookup tables of element (xml_lookup_t). Attributes of an element are
+ * stored in a linked list, so xmla() is linear in number of attributes. For
+ * attribute-heavy elements (e.g. rows with hundreds of attributes) an open
+ * addressing table of attribute pointers is built: while parsing if element
+ * has XML_ATTR_INDEX_MIN attributes or more, or with xmla_index() on demand.
+ *
+ * Same is done for children of wide elements with xml_elem_index(): table of
+ * first child element by tag, and each indexed child gets a link to its next
+ * sibling with same tag (lookup->nexttag), so xml_elem_next*() iterates over
+ * matches only.
+ *
+ * Tables are allocated in document memory, capacity is a power of two and at
+ * least twice of count, so probing always ends at an empty slot. If a name
+ * is repeated only first attribute / element (in list order) is stored, so
+ * results are same as linear lookup.
+ *
+ * Tables are not stored in xml_t to keep nodes small, document keeps them by
+ * address of element (xml_doc_t.lookups) and indexed elements are marked with
+ * xml_t.indexed. Addresses are split to chunks of XML_LOOKUP_CHUNK nodes,
+ * chunks are hashed and element is a direct slot in its chunk; siblings are
+ * allocated one after another so iterating over them stays in same chunk.
+ * xmla() etc. have no document parameter; root element of document is
+ * allocated with document pointer in front of it (xml_t.docroot), it is found
+ * by walking up from an indexed element.
+ */
+
+#ifndef xml_impl_lookup_h
+#define xml_impl_lookup_h
+
+#include "../common.h"
+#include "impl_mem.h"
+
+/* all bits of x affect low bits of result, table index is taken from them */
+XML_INLINE
+uint64_t
+xml__hash_mix(uint64_t h, uint64_t x) {
+  h ^= x;
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  return h ^ (h >> 33);
+}
+
+/*!
+ * @brief hash of name, names up to 8 bytes are hashed as packed value
+ *
+ * same hash is computed from packed names by xml__hash_packed() e.g. for
+ * xmla_packed()
+ */
+XML_INLINE
+uint64_t
+xml__hash_name(const char * __restrict name, size_t len) {
+  uint64_t h;
+  size_t   i;
+
+  h = len;
+  for (i = 0; len - i > 8; i += 8)
+    h = xml__hash_mix(h, xml__load8(name + i));
+
+  return xml__hash_mix(h, xml__pack8(name + i, len - i));
+}
+
+XML_INLINE
+uint64_t
+xml__hash_packed(uint64_t packed, size_t len) {
+  return xml__hash_mix(len, packed);
+}
+
+/*!
+ * @brief allocate root element, document is stored in front of it
+ *
+ * see xml__lookup_doc()
+ */
+XML_INLINE
+xml_t*
+xml__root_calloc(xml_doc_t * __restrict doc) {
+  xml_doc_t **mem;
+  xml_t      *obj;
+
+  /* keep alignment of xml_t */
+  if (!(mem = xml__impl_calloc(doc, sizeof(xml_t) + sizeof(void *) * 2)))
+    return NULL;
+
+  obj          = (xml_t *)(mem + 2);
+  obj->docroot = true;
+  mem[1]       = doc;
+
+  return obj;
+}
+
+/*!
+ * @brief document of element if it is in tree of a document root
+ */
+XML_INLINE
+xml_doc_t*
+xml__lookup_doc(const xml_t * __restrict obj) {
+  while (obj->parent)
+    obj = obj->parent;
+
+  return obj->docroot ? ((xml_doc_t * const *)obj)[-1] : NULL;
+}
+
+/*!
+ * @brief slots of chunk in xml_doc_t.lookups
+ *
+ * @param[in] doc document
+ * @param[in] key address of node / sizeof(xml_t) / XML_LOOKUP_CHUNK
+ * @return XML_LOOKUP_CHUNK slots or NULL
+ */
+XML_INLINE
+xml_lookup_t**
+xml__lookup_chunk(const xml_doc_t * __restrict doc, uintptr_t key) {
+  xml_lookup_chunk_t *chunk;
+  uint32_t            i, mask;
+
+  mask = doc->lookupmask;
+  i    = (uint32_t)xml__hash_mix(0, key) & mask;
+
+  while ((chunk = &doc->lookups[i])->slots) {
+    if (chunk->key == key)
+      return chunk->slots;
+
+    i = (i + 1) & mask;
+  }
+
+  return NULL;
+}
+
+XML_INLINE
+xml_lookup_t*
+xml__lookup_map(const xml_doc_t * __restrict doc,
+                const xml_t     * __restrict obj) {
+  xml_lookup_t **slots;
+  uintptr_t      n;
+
+  if (!doc->lookups)
+    return NULL;
+
+  n = (uintptr_t)obj / sizeof(xml_t);
+  if (!(slots = xml__lookup_chunk(doc, n / XML_LOOKUP_CHUNK)))
+    return NULL;
+
+  return slots[n % XML_LOOKUP_CHUNK];
+}
+
+/*!
+ * @brief lookup tables of element or NULL
+ */
+XML_INLINE
+const xml_lookup_t*
+xml__lookup_find(const xml_t * __restrict obj) {
+  const xml_doc_t *doc;
+
+  if (!obj->indexed || !(doc = xml__lookup_doc(obj)))
+    return NULL;
+
+  return xml__lookup_map(doc, obj);
+}
+
+/*!
+ * @brief add chunk to xml_doc_t.lookups, key must not be in table
+ */
+XML_INLINE
+bool
+xml__lookup_insert(xml_doc_t     * __restrict doc,
+                   uintptr_t                  key,
+                   xml_lookup_t ** __restrict slots) {
+  xml_lookup_chunk_t *chunks, *chunk;
+  uint32_t            cap, i, j;
+
+  /* grow, capacity is at least twice of count */
+  if (!doc->lookups || (doc->nlookups + 1) * 2 > doc->lookupmask + 1) {
+    cap = doc->lookups ? (doc->lookupmask + 1) * 2 : 16;
+    if (!(chunks = xml__impl_calloc(doc, cap * sizeof(*chunks))))
+      return false;
+
+    for (i = 0; doc->lookups && i <= doc->lookupmask; i++) {
+      if ((chunk = &doc->lookups[i])->slots) {
+        j = (uint32_t)xml__hash_mix(0, chunk->key) & (cap - 1);
+        while (chunks[j].slots)
+          j = (j + 1) & (cap - 1);
+
+        chunks[j] = *chunk;
+      }
+    }
+
+    doc->lookups    = chunks;
+    doc->lookupmask = cap - 1;
+  }
+
+  i = (uint32_t)xml__hash_mix(0, key) & doc->lookupmask;
+  while (doc->lookups[i].slots)
+    i = (i + 1) & doc->lookupmask;
+
+  doc->lookups[i].key   = key;
+  doc->lookups[i].slots = slots;
+  doc->nlookups++;
+
+  return true;
+}
+
+/*!
+ * @brief set lookup tables of element in xml_doc_t.lookups
+ */
+XML_INLINE
+bool
+xml__lookup_put(xml_doc_t    * __restrict doc,
+                xml_t        * __restrict obj,
+                xml_lookup_t * __restrict lookup) {
+  xml_lookup_t **slots;
+  uintptr_t      n;
+
+  n     = (uintptr_t)obj / sizeof(xml_t);
+  slots = doc->lookups ? xml__lookup_chunk(doc, n / XML_LOOKUP_CHUNK) : NULL;
+
+  if (!slots
+      && (!(slots = xml__impl_calloc(doc, XML_LOOKUP_CHUNK * sizeof(*slots)))
+          || !xml__lookup_insert(doc, n / XML_LOOKUP_CHUNK, slots)))
+    return false;
+
+  slots[n % XML_LOOKUP_CHUNK] = lookup;
+  obj->indexed                = true;
+
+  return true;
+}
+
+/*!
+ * @brief move lookup tables of other document e.g. parallel piece
+ *
+ * memory of other document must be moved to doc, chunks are reused
+ */
+XML_INLINE
+bool
+xml__lookup_merge(xml_doc_t * __restrict doc, xml_doc_t * __restrict from) {
+  xml_lookup_chunk_t *chunk;
+  xml_lookup_t      **dst;
+  uint32_t            i, j;
+
+  for (i = 0; from->lookups && i <= from->lookupmask; i++) {
+    if (!(chunk = &from->lookups[i])->slots)
+      continue;
+
+    /* a chunk may cover end of a page and begin of other document's page */
+    if (doc->lookups && (dst = xml__lookup_chunk(doc, chunk->key))) {
+      for (j = 0; j < XML_LOOKUP_CHUNK; j++)
+        if (chunk->slots[j])
+          dst[j] = chunk->slots[j];
+    } else if (!xml__lookup_insert(doc, chunk->key, chunk->slots)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+XML_INLINE
+xml_lookup_t*
+xml__lookup_get(xml_doc_t * __restrict doc, xml_t * __restrict obj) {
+  xml_lookup_t *lookup;
+
+  if (obj->indexed && (lookup = xml__lookup_map(doc, obj)))
+    return lookup;
+
+  if (!(lookup = xml__impl_calloc(doc, sizeof(xml_lookup_t)))
+      || !xml__lookup_put(doc, obj, lookup))
+    return NULL;
+
+  return lookup;
+}
+
+/*!
+ * @brief find attribute in table
+ *
+ * @param[in] lookup   lookup tables of element, attrs must not be NULL
+ * @param[in] hash     hash of name, see xml__hash_name()
+ * @param[in] name     name
+ * @param[in] namesize length of name
+ * @return attribute or NULL
+ */
+XML_INLINE
+xml_attr_t*
+xml__lookup_attr(const xml_lookup_t * __restrict lookup,
+                 uint64_t                        hash,
+                 const char         * __restrict name,
+                 size_t                          namesize) {
+  xml_attr_t *attr;
+  uint32_t    i, mask;
+
+  mask = lookup->attrmask;
+  i    = (uint32_t)hash & mask;
+
+  while ((attr = lookup->attrs[i])) {
+    if ((size_t)attr->namesize == namesize
+        && (!namesize
+            || (attr->name[0] == name[0]
+                && xml__bytes_eq(attr->name, name, namesize))))
+      return attr;
+
+    i = (i + 1) & mask;
+  }
+
+  return NULL;
+}
+
+/*!
+ * @brief unpack name from packed value, see xml__pack8()
+ */
+XML_INLINE
+void
+xml__unpack8(char * __restrict name, uint64_t packed, size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    name[i] = (char)(uint8_t)(packed >> (i * 8));
+}
+
+XML_INLINE
+xml_attr_t*
+xml__lookup_attr_packed(const xml_lookup_t * __restrict lookup,
+                        uint64_t                        packed,
+                        size_t                          namesize) {
+  char name[8];
+
+  if (namesize > 8)
+    return NULL;
+
+  xml__unpack8(name, packed, namesize);
+  return xml__lookup_attr(lookup,
+                          xml__hash_packed(packed, namesize),
+                          name,
+                          namesize);
+}
+
+XML_INLINE
+bool
+xmla_index(xml_doc_t * __restrict doc, xml_t * __restrict object) {
+  xml_lookup_t  *lookup;
+  xml_attr_t    *attr, **slots;
+  uint32_t       count, cap, i;
+
+  if (!doc || !object || object->type != XML_ELEMENT)
+    return false;
+
+  count = 0;
+  for (attr = object->attr; attr; attr = attr->next)
+    count++;
+
+  for (cap = 8; cap < count * 2; cap <<= 1);
+
+  if (!(lookup = xml__lookup_get(doc, object))
+      || !(slots = xml__impl_calloc(doc, cap * sizeof(*slots))))
+    return false;
+
+  for (attr = object->attr; attr; attr = attr->next) {
+    if (!attr->name)
+      continue;
+
+    i = (uint32_t)xml__hash_name(attr->name, attr->namesize) & (cap - 1);
+    while (slots[i]
+           && ((size_t)slots[i]->namesize != attr->namesize
+               || !xml__bytes_eq(slots[i]->name, attr->name, attr->namesize)))
+      i = (i + 1) & (cap - 1);
+
+    /* keep first one if name is repeated */
+    if (!slots[i])
+      slots[i] = attr;
+  }
+
+  lookup->attrs    = slots;
+  lookup->attrmask = cap - 1;
+
+  return true;
+}
+
+/*!
+ * @brief find first child element by tag in table
+ *
+ * @param[in] lookup   lookup tables of element, elems must not be NULL
+ * @param[in] hash     hash of name, see xml__hash_name()
+ * @param[in] name     tag
+ * @param[in] namesize length of tag
+ * @return element or NULL
+ */
+XML_INLINE
+xml_t*
+xml__lookup_elem(const xml_lookup_t * __restrict lookup,
+                 uint64_t                        hash,
+                 const char         * __restrict name,
+                 size_t                          namesize) {
+  xml_t    *elem;
+  uint32_t  i, mask;
+
+  mask = lookup->elemmask;
+  i    = (uint32_t)hash & mask;
+
+  while ((elem = lookup->elems[i])) {
+    if ((size_t)elem->tagsize == namesize
+        && (!namesize
+            || (elem->tag[0] == name[0]
+                && xml__bytes_eq(elem->tag, name, namesize))))
+      return elem;
+
+    i = (i + 1) & mask;
+  }
+
+  return NULL;
+}
+
+XML_INLINE
+xml_t*
+xml__lookup_elem_packed(const xml_lookup_t * __restrict lookup,
+                        uint64_t                        packed,
+                        size_t                          namesize) {
+  char name[8];
+
+  if (namesize > 8)
+    return NULL;
+
+  xml__unpack8(name, packed, namesize);
+  return xml__lookup_elem(lookup,
+                          xml__hash_packed(packed, namesize),
+                          name,
+                          namesize);
+}
+
+/*!
+ * @brief tables of current if it is linked to its next sibling with same tag
+ */
+XML_INLINE
+const xml_lookup_t*
+xml__lookup_linked(const xml_t * __restrict current) {
+  const xml_doc_t    *doc;
+  const xml_lookup_t *lookup;
+
+  if (current->type != XML_ELEMENT
+      || !current->indexed
+      || !current->parent
+      || !current->parent->indexed
+      || !(doc = xml__lookup_doc(current))
+      || !(lookup = xml__lookup_map(doc, current->parent))
+      || !lookup->elems)
+    return NULL;
+
+  return xml__lookup_map(doc, current);
+}
+
+XML_INLINE
+bool
+xml_elem_index(xml_doc_t * __restrict doc, xml_t * __restrict object) {
+  xml_lookup_t  *lookup, *links, *link, *prev;
+  xml_t         *child, *last, **slots;
+  uint32_t       count, nolookup, cap, i;
+
+  if (!doc || !object || object->type != XML_ELEMENT)
+    return false;
+
+  count = nolookup = 0;
+  links = NULL;
+  for (child = object->val; child; child = child->next) {
+    if (child->type == XML_ELEMENT && child->tag) {
+      count++;
+      nolookup += !child->indexed || !xml__lookup_map(doc, child);
+    }
+  }
+
+  for (cap = 8; cap < count * 2; cap <<= 1);
+
+  /* old links are not valid while rebuilding */
+  if (object->indexed && (lookup = xml__lookup_map(doc, object)))
+    lookup->elems = NULL;
+
+  if (!(lookup = xml__lookup_get(doc, object))
+      || !(slots = xml__impl_calloc(doc, cap * sizeof(*slots)))
+      || (nolookup
+          && !(links = xml__impl_calloc(doc, nolookup * sizeof(*links)))))
+    return false;
+
+  /*
+   * while building, slot stores last element of tag and nexttag of last one
+   * points to first one (circular), so first ones are known without another
+   * table.
+   */
+  for (child = object->val; child; child = child->next) {
+    if (child->type != XML_ELEMENT || !child->tag)
+      continue;
+
+    if (!child->indexed || !(link = xml__lookup_map(doc, child))) {
+      link = links++;
+      if (!xml__lookup_put(doc, child, link))
+        return false;
+    }
+
+    i = (uint32_t)xml__hash_name(child->tag, child->tagsize) & (cap - 1);
+    while ((last = slots[i])
+           && ((size_t)last->tagsize != child->tagsize
+               || !xml__bytes_eq(last->tag, child->tag, child->tagsize)))
+      i = (i + 1) & (cap - 1);
+
+    if (last) {
+      prev          = xml__lookup_map(doc, last);
+      link->nexttag = prev->nexttag;
+      prev->nexttag = child;
+    } else {
+      link->nexttag = child;
+    }
+
+    slots[i] = child;
+  }
+
+  for (i = 0; i < cap; i++) {
+    if ((last = slots[i])) {
+      link          = xml__lookup_map(doc, last);
+      slots[i]      = link->nexttag;
+      link->nexttag = NULL;
+    }
+  }
+
+  lookup->elems    = slots;
+  lookup->elemmask = cap - 1;
+
+  return true;
+}
+
+#endif /* xml_impl_lookup_h */
@@ -23,25 +23,151 @@ typedef struct xml_mem_t {
 
 XML_INLINE
 void*
-xml__impl_calloc(xml_doc_t * __restrict doc, size_t size) {
-  void      *data;
+xml__default_alloc(void *ctx, size_t size) {
+  (void)ctx;
+  return malloc(size);
+}
+
+XML_INLINE
+void
+xml__default_free(void *ctx, void *ptr) {
+  (void)ctx;
+  free(ptr);
+}
+
+XML_INLINE
+void*
+xml__alloc(xml_doc_t * __restrict doc, size_t size) {
+  return doc->allocator.alloc(doc->allocator.ctx, size);
+}
+
+XML_INLINE
+void
+xml__free(xml_doc_t *doc, void *ptr) {
+  doc->allocator.free(doc->allocator.ctx, ptr);
+}
+
+XML_INLINE
+void
+xml__mem_free(xml_doc_t * __restrict doc, xml_mem_t * __restrict mem) {
+  xml_mem_t *tofree;
+
+  while (mem) {
+    tofree = mem;
+    mem    = mem->next;
+    xml__free(doc, tofree);
+  }
+}
+
+/*!
+ * @brief make a page which has at least size bytes the current page
+ *
+ * spare page (see xml_doc_reset()) is used if it is big enough.
+ */
+XML_INLINE
+xml_mem_t*
+xml__mem_page(xml_doc_t * __restrict doc, size_t size) {
+  xml_mem_t *mem;
+
+  if ((mem = doc->memspare) && mem->capacity >= size) {
+    doc->memspare = mem->next;
+  } else {
+    size = (XML_MEM_PAGE < size) ? size : XML_MEM_PAGE;
+    if (!(mem = xml__alloc(doc, sizeof(*mem) + size)))
+      return NULL;
+
+    mem->capacity = size;
+  }
+
+  mem->size    = 0;
+  mem->next    = doc->memroot;
+  doc->memroot = mem;
+
+  return mem;
+}
+
+/*!
+ * @brief make sure that current page has at least size free bytes
+ *
+ * empty current page (e.g. page of new document) is moved to spare list
+ * instead of leaving it unused in page list.
+ */
+XML_INLINE
+void
+xml__mem_reserve(xml_doc_t * __restrict doc, size_t size) {
   xml_mem_t *mem;
-  size_t     sizeToAlloc;
-  
-  mem         = doc->memroot;
-  sizeToAlloc = (XML_MEM_PAGE < size) ? size : XML_MEM_PAGE;
-  
-  if (mem->capacity < (mem->size + size)) {
-    mem           = calloc(1, sizeof(*mem) + sizeToAlloc);
-    mem->capacity = sizeToAlloc;
-    mem->next     = doc->memroot;
-    doc->memroot  = mem;
+
+  mem = doc->memroot;
+  if (mem->capacity - mem->size >= size)
+    return;
+
+  if (mem->size != 0) {
+    xml__mem_page(doc, size);
+    return;
+  }
+
+  doc->memroot = mem->next;
+  if (!xml__mem_page(doc, size)) {
+    doc->memroot = mem;
+    return;
   }
-  
+
+  mem->next     = doc->memspare;
+  doc->memspare = mem;
+}
+
+/*!
+ * @brief free all pages except current one, current page is emptied
+ */
+XML_INLINE
+void
+xml__mem_release(xml_doc_t * __restrict doc) {
+  xml_mem_t *mem;
+
+  mem = doc->memroot;
+  xml__mem_free(doc, mem->next);
+  xml__mem_free(doc, doc->memspare);
+
+  mem->next     = NULL;
+  mem->size     = 0;
+  doc->memspare = NULL;
+}
+
+/*!
+ * @brief allocate from document's memory, memory is not zeroed
+ */
+XML_INLINE
+void*
+xml__impl_alloc(xml_doc_t * __restrict doc, size_t size) {
+  void      *data;
+  xml_mem_t *mem;
+
+  mem = doc->memroot;
+  if (mem->capacity < (mem->size + size)
+      && !(mem = xml__mem_page(doc, size)))
+    return NULL;
+
   data       = (char *)mem->data + mem->size;
   mem->size += size;
 
   return data;
 }
 
+/*!
+ * @brief allocate zeroed memory from document's memory
+ *
+ * pages are not zeroed when they are allocated or reused, only the bytes
+ * which are used.
+ */
+XML_INLINE
+void*
+xml__impl_calloc(xml_doc_t * __restrict doc, size_t size) {
+  void *data;
+
+  if ((data = xml__impl_alloc(doc, size)))
+    memset(data, 0, size);
+
+  return data;
+}
+
 #endif /* xml_impl_mem_h */
@@ -10,6 +10,7 @@
 
 #include "../xml.h"
 #include "impl_mem.h"
+#include "impl_lookup.h"
 #include "../util.h"
 
 XML_INLINE
@@ -82,4 +83,193 @@ xml_objmap_call(xml_t        * __restrict obj,
   }
 }
 
+XML_INLINE
+uint32_t
+xml__cobjmap_slot(uint64_t hash, uint64_t seed, uint32_t mask) {
+  return (uint32_t)(((hash ^ seed) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+/*!
+ * @brief try to place keys into slots without collision by using seed,
+ *        entries of same key are linked in map order
+ *
+ * @return false if two different keys have same slot
+ */
+XML_INLINE
+bool
+xml__cobjmap_place(xml_cobjmap_t  * __restrict cmap,
+                   const uint64_t * __restrict hashes) {
+  xml_cobjmap_slot_t *slot;
+  xml_objmap_t       *item, *first;
+  size_t              i;
+
+  memset(cmap->slots, 0, ((size_t)cmap->mask + 1) * sizeof(*cmap->slots));
+
+  for (i = 0; i < cmap->count; i++) {
+    item = &cmap->objmap[i];
+    if (!item->key)
+      continue;
+
+    slot          = &cmap->slots[xml__cobjmap_slot(hashes[i],
+                                                   cmap->seed,
+                                                   cmap->mask)];
+    cmap->next[i] = 0;
+
+    if (!slot->first) {
+      slot->first = (uint32_t)i + 1;
+    } else {
+      first = &cmap->objmap[slot->first - 1];
+      if (first->keysize != item->keysize
+          || !xml__bytes_eq(first->key, item->key, item->keysize))
+        return false;
+
+      cmap->next[slot->last] = (uint32_t)i + 1;
+    }
+
+    slot->last = (uint32_t)i;
+  }
+
+  return true;
+}
+
+XML_INLINE
+xml_cobjmap_t*
+xml_cobjmap_new(xml_objmap_t * __restrict objmap, size_t count) {
+  xml_cobjmap_t *cmap;
+  uint64_t      *hashes;
+  xml_objmap_t  *item;
+  size_t         i;
+  uint32_t       cap, attempt;
+
+  if (!objmap || count == 0 || count >= UINT32_MAX / 4)
+    return NULL;
+
+  if (!(cmap = calloc(1, sizeof(*cmap) + count * sizeof(*cmap->next))))
+    return NULL;
+
+  if (!(hashes = malloc(count * sizeof(*hashes)))) {
+    free(cmap);
+    return NULL;
+  }
+
+  cmap->objmap = objmap;
+  cmap->count  = count;
+  cmap->next   = (uint32_t *)(cmap + 1);
+
+  for (i = 0; i < count; i++) {
+    item = &objmap[i];
+    if (!item->key)
+      continue;
+
+    if (!item->keysize)
+      item->keysize = strlen(item->key);
+
+    hashes[i] = xml__hash_name(item->key, item->keysize);
+  }
+
+  /* table is 4x sparse at least, seeds are tried before it is grown */
+  for (cap = 8; cap < count * 4; cap <<= 1);
+
+  for (; cap <= (1u << 24); cap <<= 1) {
+    free(cmap->slots);
+    if (!(cmap->slots = malloc(cap * sizeof(*cmap->slots))))
+      break;
+
+    cmap->mask = cap - 1;
+    for (attempt = 0; attempt < 1024; attempt++) {
+      cmap->seed = xml__hash_mix(cap, attempt);
+      if (xml__cobjmap_place(cmap, hashes)) {
+        free(hashes);
+        return cmap;
+      }
+    }
+  }
+
+  free(hashes);
+  xml_cobjmap_free(cmap);
+  return NULL;
+}
+
+XML_INLINE
+void
+xml_cobjmap_free(xml_cobjmap_t * __restrict cmap) {
+  if (!cmap)
+    return;
+
+  free(cmap->slots);
+  free(cmap);
+}
+
+XML_INLINE
+void
+xml_cobjmap(xml_t * __restrict obj, xml_cobjmap_t * __restrict cmap) {
+  const xml_cobjmap_slot_t *slot;
+  xml_objmap_t             *objmap, *item;
+  size_t                    i, remaining;
+
+  if (!cmap)
+    return;
+
+  objmap    = cmap->objmap;
+  remaining = 0;
+  for (i = 0; i < cmap->count; i++) {
+    objmap[i].object = NULL;
+    remaining       += objmap[i].key != NULL;
+  }
+
+  if (!obj || obj->type != XML_ELEMENT)
+    return;
+
+  for (obj = obj->val; obj && remaining; obj = obj->next) {
+    if (obj->type != XML_ELEMENT || !obj->tag)
+      continue;
+
+    slot = &cmap->slots[xml__cobjmap_slot(xml__hash_name(obj->tag,
+                                                         obj->tagsize),
+                                          cmap->seed,
+                                          cmap->mask)];
+    if (!slot->first)
+      continue;
+
+    item = &objmap[slot->first - 1];
+    if (item->keysize != (size_t)obj->tagsize
+        || !xml__bytes_eq(item->key, obj->tag, item->keysize)
+        || objmap[slot->last].object) /* all entries of key are found */
+      continue;
+
+    while (item->object)
+      item = &objmap[cmap->next[item - objmap] - 1];
+
+    item->object = obj;
+    remaining--;
+  }
+}
+
+XML_INLINE
+void
+xml_cobjmap_call(xml_t         * __restrict obj,
+                 xml_cobjmap_t * __restrict cmap,
+                 bool          * __restrict stop) {
+  xml_objmap_t *item;
+  size_t        i;
+
+  if (!obj || obj->type != XML_ELEMENT || !cmap)
+    return;
+
+  xml_cobjmap(obj, cmap);
+
+  for (i = 0; i < cmap->count; i++) {
+    if (stop && *stop)
+      break;
+
+    item = &cmap->objmap[i];
+    if (item->object) {
+      if (item->foundFunc.func)
+        item->foundFunc.func(item->object, item->foundFunc.param);
+    } else if (item->notFoundFunc.func) {
+      item->notFoundFunc.func(item->object, item->notFoundFunc.param);
+    }
+  }
+}
+
 #endif /* xml_impl_objmap_h */
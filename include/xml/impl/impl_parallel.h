@@ -0,0 +1,435 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Root's content is split near to equal sized points at start tag of root's
+ * last child (it is found by scanning backwards from root's end tag), so no
+ * sequential pre-scan is needed. A split point may still be wrong (same tag
+ * is nested, or it is in a comment / CDATA), then one of the pieces doesn't
+ * parse at depth 0 or it doesn't end at depth 0. Since stage 2 writes null
+ * terminators, pieces are verified with tokenizer (in parallel) before tree
+ * is built unless XML_READONLY is used; in readonly mode tree construction
+ * verifies pieces itself and it is safe to fall back to xml_parse_n().
+ *
+ * Each piece is parsed into its own document (memory) with stage 2, then
+ * top level nodes of pieces are linked under root and memory pages are moved
+ * to main document. With XML_ATOMS names of pieces are interned after linking
+ * since symbol table of main document can't be shared by threads.
+ */
+
+#ifndef xml_impl_parallel_h
+#define xml_impl_parallel_h
+
+#include "../parallel.h"
+#include "impl_mem.h"
+#include "impl_scan.h"
+#include "impl_token.h"
+#include "impl_parse.h"
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+typedef HANDLE xml__thread_t;
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+typedef pthread_t xml__thread_t;
+#endif
+
+typedef struct xml__piece_t {
+  char          *begin;
+  char          *end;
+  xml_t         *parent;  /* root element                            */
+  xml_doc_t     *doc;     /* memory of piece, moved to main document */
+  xml_t         *head;    /* first top level node in link order      */
+  xml_t         *tail;    /* last top level node in link order       */
+  size_t         offset;  /* offset of begin in contents, for errors */
+  xml_options_t  options;
+  bool           verify;  /* only verify, don't build tree           */
+  bool           exact;   /* nothing is skipped under root, xml_src() */
+  bool           ok;
+} xml__piece_t;
+
+XML_STATIC
+void
+xml__piece_run(xml__piece_t * __restrict piece) {
+  xml__tok_t       tok;
+  xml__state_t     st;
+  xml_t            tmproot, *it;
+  xml__tok_kind_t  t;
+
+  if (piece->verify) {
+    xml__tok_init(&tok, piece->begin, (size_t)(piece->end - piece->begin),
+                  false);
+    while ((t = xml__tok_next(&tok)) > XML__TOK_ERROR);
+
+    piece->ok = t == XML__TOK_EOF;
+    return;
+  }
+
+  if (!(piece->doc = xml__doc_new(piece->options))) {
+    piece->ok = false;
+    return;
+  }
+
+  if (piece->options & XML_PRESCAN)
+    xml__doc_prescan(piece->doc,
+                     piece->begin,
+                     (size_t)(piece->end - piece->begin));
+
+  xml__state_init(&st, piece->doc, &tmproot);
+  st.roottext = true;
+  st.offset   = piece->offset;
+
+  if (!xml__parse_run(&st, piece->begin, piece->end) || st.obj != &tmproot) {
+    piece->ok = false;
+    return;
+  }
+
+  /*
+   * temporary root is never closed, see xml__link(). Text at the end of piece
+   * is null terminated by next piece ('<' of its first tag).
+   */
+  it          = st.reverse ? tmproot.val : tmproot.next;
+  piece->head = it;
+  piece->tail = NULL;
+
+  for (; it; it = it->next) {
+    it->parent  = piece->parent;
+    piece->tail = it;
+  }
+
+  piece->exact = tmproot.exact;
+  piece->ok    = true;
+}
+
+#if defined(_WIN32)
+XML_INLINE
+DWORD WINAPI
+xml__piece_thread(LPVOID arg) {
+  xml__piece_run(arg);
+  return 0;
+}
+#else
+XML_INLINE
+void*
+xml__piece_thread(void *arg) {
+  xml__piece_run(arg);
+  return NULL;
+}
+#endif
+
+/*!
+ * @brief run pieces concurrently, first piece is run on caller's thread
+ *
+ * @return true if all pieces are ok
+ */
+XML_INLINE
+bool
+xml__pieces_run(xml__piece_t * __restrict pieces, uint32_t n) {
+  xml__thread_t th[XML_PARALLEL_MAX];
+  bool          started[XML_PARALLEL_MAX];
+  uint32_t      i;
+  bool          ok;
+
+  for (i = 1; i < n; i++) {
+#if defined(_WIN32)
+    th[i]      = CreateThread(NULL, 0, xml__piece_thread, &pieces[i], 0,
+                              NULL);
+    started[i] = th[i] != NULL;
+#else
+    started[i] = pthread_create(&th[i],
+                                NULL,
+                                xml__piece_thread,
+                                &pieces[i]) == 0;
+#endif
+    if (!started[i])
+      xml__piece_run(&pieces[i]);
+  }
+
+  xml__piece_run(&pieces[0]);
+  ok = pieces[0].ok;
+
+  for (i = 1; i < n; i++) {
+    if (started[i]) {
+#if defined(_WIN32)
+      WaitForSingleObject(th[i], INFINITE);
+      CloseHandle(th[i]);
+#else
+      pthread_join(th[i], NULL);
+#endif
+    }
+
+    ok = ok && pieces[i].ok;
+  }
+
+  return ok;
+}
+
+XML_INLINE
+uint32_t
+xml__cpu_count(void) {
+#if defined(_WIN32)
+  SYSTEM_INFO si;
+
+  GetSystemInfo(&si);
+  return si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  long n;
+
+  return (n = sysconf(_SC_NPROCESSORS_ONLN)) > 0 ? (uint32_t)n : 1;
+#else
+  return 1;
+#endif
+}
+
+/*!
+ * @brief find last '<' in [begin, end) which starts markup that ends at end
+ *
+ * @return position of '<' or NULL if there is no such markup
+ */
+XML_INLINE
+char*
+xml__last_markup(char * __restrict begin, char * __restrict end) {
+  while (end > begin && xml__ascii_space(end[-1]))
+    end--;
+
+  if (end == begin || end[-1] != '>')
+    return NULL;
+
+  for (end--; end > begin; ) {
+    if (*--end == '<')
+      return end;
+  }
+
+  return NULL;
+}
+
+/*!
+ * @brief find content of root and tag of its last child
+ *
+ * @param[in]  contents XML string
+ * @param[in]  len      length of contents
+ * @param[out] begin    first byte after root's start tag
+ * @param[out] end      '<' of root's end tag
+ * @param[out] tag      tag of root's last child (with prefix)
+ * @param[out] tagsize  length of tag
+ * @return false if document doesn't have this structure
+ */
+XML_INLINE
+bool
+xml__parallel_bounds(const char  * __restrict contents,
+                     size_t                   len,
+                     char       ** __restrict begin,
+                     char       ** __restrict end,
+                     char       ** __restrict tag,
+                     size_t      * __restrict tagsize) {
+  xml__tok_t       tok;
+  xml__tok_kind_t  t;
+  char            *p, *q;
+
+  /* root's start tag */
+  xml__tok_init(&tok, contents, len, false);
+  while ((t = xml__tok_next(&tok)) > XML__TOK_ERROR && t != XML__TOK_START);
+
+  if (t != XML__TOK_START)
+    return false;
+
+  while (xml__tok_attr(&tok));
+
+  if (tok.p >= tok.pend || *tok.p != '>')
+    return false;
+
+  *begin = (char *)tok.p + 1;
+
+  /* root's end tag */
+  if (!(p = xml__last_markup(*begin, (char *)contents + len)) || p[1] != '/')
+    return false;
+
+  *end = p;
+
+  /* root's last child */
+  if (!(p = xml__last_markup(*begin, *end)) || p[1] == '!' || p[1] == '?')
+    return false;
+
+  p += p[1] == '/' ? 2 : 1;
+  q  = (char *)xml__scan_name_end(p, *end);
+
+  *tag     = p;
+  *tagsize = (size_t)(q - p);
+
+  return q > p && q < *end;
+}
+
+XML_INLINE
+xml_doc_t*
+xml_parse_parallel(const char * __restrict contents,
+                   size_t                   len,
+                   xml_options_t            options,
+                   uint32_t                 nthreads) {
+  xml__piece_t  pieces[XML_PARALLEL_MAX];
+  xml__state_t  st;
+  xml_t         tmproot, *root;
+  xml_doc_t    *doc;
+  xml_mem_t    *mem, *head;
+  char         *begin, *end, *tag, *p, *prev, c;
+  size_t        tagsize, size;
+  uint32_t      n, i, k;
+
+  if (!contents || len == 0)
+    return NULL;
+
+  if (nthreads == 0)
+    nthreads = xml__cpu_count();
+
+  n = (uint32_t)(len / XML_PARALLEL_MIN < XML_PARALLEL_MAX
+                   ? len / XML_PARALLEL_MIN
+                   : XML_PARALLEL_MAX);
+  if (nthreads < n)
+    n = nthreads;
+
+  if (n < 2
+      || !xml__parallel_bounds(contents, len, &begin, &end, &tag, &tagsize))
+    return xml_parse_n(contents, len, options);
+
+  /* split points: start tags of root's children */
+  size = (size_t)(end - begin);
+  prev = begin;
+  k    = 0;
+
+  for (i = 1; i < n; i++) {
+    p = begin + size / n * i;
+    if (p <= prev)
+      p = prev + 1;
+
+    while ((p = (char *)xml__scan_byte(p, end, '<')) < end) {
+      if ((size_t)(end - p) > tagsize + 1
+          && xml__bytes_eq(p + 1, tag, tagsize)
+          && ((c = p[tagsize + 1]) == '>' || c == '/' || xml__ascii_space(c)))
+        break;
+      p++;
+    }
+
+    if (p >= end)
+      break;
+
+    memset(&pieces[k], 0, sizeof(pieces[k]));
+    pieces[k].begin = prev;
+    pieces[k].end   = p;
+    prev            = p;
+    k++;
+  }
+
+  memset(&pieces[k], 0, sizeof(pieces[k]));
+  pieces[k].begin = prev;
+  pieces[k].end   = end;
+  n               = k + 1;
+
+  if (n < 2)
+    return xml_parse_n(contents, len, options);
+
+  /* null terminators would be written while building tree, verify first */
+  if (!(options & XML_READONLY)) {
+    for (i = 0; i < n; i++)
+      pieces[i].verify = true;
+
+    if (!xml__pieces_run(pieces, n))
+      return xml_parse_n(contents, len, options);
+  }
+
+  if (!(doc = xml__doc_new(options)))
+    return NULL;
+
+  doc->ptr = contents;
+  xml__state_init(&st, doc, &tmproot);
+
+  /* prolog and root's start tag */
+  if (!xml__parse_run(&st, (char *)contents, begin) || st.obj == &tmproot)
+    return xml__state_finish(&st);
+
+  root = st.obj;
+  for (i = 0; i < n; i++) {
+    pieces[i].verify  = false;
+    pieces[i].parent  = root;
+    pieces[i].options = options & ~XML_ATOMS;
+    pieces[i].offset  = (size_t)(pieces[i].begin - contents);
+  }
+
+  if (!xml__pieces_run(pieces, n)) {
+    /* first error in document order */
+    for (i = 0; i < n; i++) {
+      if (pieces[i].doc) {
+        if (pieces[i].doc->error.code != XML_OK)
+          xml__error(doc,
+                     pieces[i].doc->error.code,
+                     pieces[i].doc->error.offset,
+                     pieces[i].doc->error.expected);
+
+        xml_free(pieces[i].doc);
+      }
+    }
+
+    if (options & XML_READONLY) {
+      xml_free(doc);
+      return xml_parse_n(contents, len, options);
+    }
+
+    /* pieces were verified, so document is malformed e.g. end tag mismatch */
+    return xml__state_finish(&st);
+  }
+
+  /* link top level nodes of pieces under root in document order */
+  head = doc->memroot;
+  for (i = 0; i < n; i++) {
+    if (pieces[i].head) {
+      if (!st.reverse) {
+        if (!root->next)
+          root->next = pieces[i].head;
+        else
+          xml_xml(root)->next = pieces[i].head;
+
+        root->val = pieces[i].tail;
+      } else {
+        pieces[i].tail->next = root->val;
+        root->val            = pieces[i].head;
+      }
+    }
+
+    if (!pieces[i].exact)
+      root->exact = false;
+
+    /* keep current page of main document at head */
+    for (mem = pieces[i].doc->memroot; mem->next; mem = mem->next);
+
+    mem->next  = head->next;
+    head->next = pieces[i].doc->memroot;
+
+    doc->prescan.nodes += pieces[i].doc->prescan.nodes;
+    doc->prescan.attrs += pieces[i].doc->prescan.attrs;
+
+    /* lookup tables of piece are in moved pages, key them in main document */
+    if (!xml__lookup_merge(doc, pieces[i].doc))
+      xml__error(doc, XML_ERR_NOMEM, (size_t)(begin - contents), NULL);
+
+    xml__mem_free(pieces[i].doc, pieces[i].doc->memspare);
+    xml__free(pieces[i].doc, pieces[i].doc);
+  }
+
+  /* pieces don't share symbol table, intern their names here */
+  if (st.intern && !xml__atoms_tree(doc, st.reverse ? root->val : root->next))
+    xml__error(doc, XML_ERR_NOMEM, (size_t)(begin - contents), NULL);
+
+  /* root's end tag and rest of document */
+  st.offset = (size_t)(end - contents);
+  xml__parse_run(&st, end, (char *)contents + len);
+
+  return xml__state_finish(&st);
+}
+
+#endif /* xml_impl_parallel_h */
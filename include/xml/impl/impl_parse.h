@@ -10,429 +10,572 @@
 
 #include "../xml.h"
 #include "impl_mem.h"
+#include "impl_scan.h"
+#include "impl_index.h"
+#include "impl_token.h"
+#include "impl_lookup.h"
+#include "impl_atom.h"
 
-typedef enum xml_position {
-  unknown   = 0,
-  begintag  = 1,
-  endtag    = 2,
-  beginel   = 3,
-  endel     = 4,
-  beginattr = 5
-} xml_position;
+/*
+ * Parser works in two stages:
+ *
+ *   1. structural index (impl_index.h): input is classified in vector sized
+ *      blocks into bitmaps of structural characters (< > = and quotes).
+ *
+ *   2. tree construction (below): parser jumps between structural positions
+ *      by using the index and creates xml_t / xml_attr_t nodes. Bytes between
+ *      structural characters (text, attribute values...) are never visited
+ *      one by one, only names and whitespace runs are scanned. Payload of
+ *      comments and CDATA is not indexed, its end is found by vector scan.
+ *
+ * Index is built for a small window at a time, see impl_index.h.
+ */
+
+XML_INLINE
+void
+xml__link(xml_t * __restrict parent,
+          xml_t * __restrict obj,
+          bool               reverse) {
+  /*
+   * in normal order, while parent is open, parent->next points to first child
+   * and parent->val points to last child. They are swapped back when parent is
+   * closed. See xml__close().
+   */
+  if (!reverse) {
+    if (!parent->next)
+      parent->next = obj;
+    else
+      xml_xml(parent)->next = obj;
+  } else {
+    obj->next = parent->val;
+  }
+
+  parent->val = obj;
+  obj->parent = parent;
+}
+
+XML_INLINE
+xml_t*
+xml__close(xml_t * __restrict obj, bool reverse) {
+  if (!reverse) {
+    obj->val  = obj->next;
+    obj->next = NULL;
+  }
+
+  /* source of parent has skipped bytes too, see xml_src() */
+  if (!obj->exact)
+    obj->parent->exact = false;
+
+  return obj->parent;
+}
+
+/*
+ * parser state between xml__parse_run() calls, parser can be resumed at
+ * markup boundaries (after '>') with this state, see push.h
+ */
+typedef struct xml__state_t {
+  xml_doc_t *doc;
+  xml_t     *root;   /* temporary root which holds top level nodes */
+  xml_t     *obj;    /* current open element                       */
+  bool       reverse;
+  bool       sepPrefixes;
+  bool       readonly;
+  bool       comments;
+  bool       intern;   /* XML_ATOMS                                       */
+  bool       roottext; /* keep text under temporary root (partial parse) */
+  bool       spans;    /* contents are contiguous, mark exact elements   */
+  size_t     offset;   /* offset of next run in contents, for errors      */
+} xml__state_t;
+
+XML_INLINE
+void
+xml__doc_options(xml_doc_t * __restrict doc, xml_options_t options) {
+  doc->reverse     = options & XML_REVERSE;
+  doc->readonly    = options & XML_READONLY;
+  doc->sepPrefixes = options & XML_PREFIXES;
+  doc->comments    = options & XML_COMMENTS;
+  doc->failfast    = options & XML_FAILFAST;
+  doc->intern      = options & XML_ATOMS;
+}
+
+/*!
+ * @brief record error, only first error of document is kept
+ */
+XML_INLINE
+void
+xml__error(xml_doc_t  * __restrict doc,
+           xml_error_code_t        code,
+           size_t                  offset,
+           const char * __restrict expected) {
+  if (doc->error.code != XML_OK)
+    return;
+
+  doc->error.code     = code;
+  doc->error.offset   = offset;
+  doc->error.expected = expected;
+}
+
+XML_INLINE
+void
+xml_prescan(const char    * __restrict contents,
+            size_t                     len,
+            xml_prescan_t * __restrict counts) {
+  if (!contents) {
+    counts->nodes = counts->attrs = 0;
+    return;
+  }
+
+  xml__count_byte2(contents, contents + len, '<', '=',
+                   &counts->nodes, &counts->attrs);
+}
+
+/*!
+ * @brief count nodes of [p, p + len) and allocate memory for them at once
+ */
+XML_INLINE
+void
+xml__doc_prescan(xml_doc_t  * __restrict doc,
+                 const char * __restrict p,
+                 size_t                  len) {
+  xml_prescan_t *counts;
+
+  counts = &doc->prescan;
+  xml_prescan(p, len, counts);
+
+  /* size wouldn't fit, let memory grow page by page */
+  if (counts->nodes > SIZE_MAX / 2 / sizeof(xml_t)
+      || counts->attrs > SIZE_MAX / 2 / sizeof(xml_attr_t))
+    return;
+
+  xml__mem_reserve(doc, counts->nodes * sizeof(xml_t)
+                        + counts->attrs * sizeof(xml_attr_t));
+}
 
 XML_INLINE
 xml_doc_t*
-xml_parse(const char * __restrict contents, xml_options_t options) {
-  xml_doc_t   *doc;
-  xml_t       *obj, *parent, *val;
-  xml_attr_t  *attr;
-  const char  *tag, *s;
-  xml_t        tmproot;
-  xml_position pos;
-  char        *p, *end, c, quote;
-  bool         foundQuote, reverse, sepPrefixes, readonly;
-  
-  if (!contents || (c = *contents) == '\0')
-    return NULL;
-  
-  doc            = calloc(1, sizeof(*doc));
-  doc->memroot   = calloc(1, sizeof(xml_mem_t) + XML_MEM_PAGE);
-  p              = (char *)contents;
-
-  memset(&tmproot, 0, sizeof(tmproot));
-  tmproot.type   = XML_ELEMENT;
-
-  s              = NULL;
-  attr           = NULL;
-  tag            = NULL;
-  parent         = &tmproot;
-  obj            = parent;
-  pos            = unknown;
-  quote          = '"';
-
-  reverse        = options & XML_REVERSE;
-  sepPrefixes    = options & XML_PREFIXES;
-  readonly       = options & XML_READONLY;
-
-  doc->reverse     = reverse;
-  doc->readonly    = readonly;
-  doc->sepPrefixes = sepPrefixes;
-
-  tmproot.readonly = readonly;
-  tmproot.reverse  = reverse;
-  
-  ((xml_mem_t *)doc->memroot)->capacity = XML_MEM_PAGE;
-  
-  do {
-  again:
-    /* child */
-    switch (c) {
-        /* trim */
-      case ' ':
-      case '\r':
-      case '\n':
-      case '\t':
-        do {
-          c = *++p;
-        } while (c == ' ' || c == '\r' || c == '\n' || c == '\t');
-
-        if (c == '\0')
-          goto err;
+xml__doc_new(xml_options_t options) {
+  xml_doc_t *doc;
+
+  if ((doc = xml_doc_new(NULL)))
+    xml__doc_options(doc, options);
+
+  return doc;
+}
+
+XML_INLINE
+void
+xml__state_init(xml__state_t * __restrict st,
+                xml_doc_t    * __restrict doc,
+                xml_t        * __restrict tmproot) {
+  memset(tmproot, 0, sizeof(*tmproot));
+  tmproot->type     = XML_ELEMENT;
+  tmproot->readonly = doc->readonly;
+  tmproot->reverse  = doc->reverse;
+  tmproot->exact    = true;
+
+  st->doc         = doc;
+  st->root        = tmproot;
+  st->obj         = tmproot;
+  st->reverse     = doc->reverse;
+  st->sepPrefixes = doc->sepPrefixes;
+  st->readonly    = doc->readonly;
+  st->comments    = doc->comments;
+  st->intern      = doc->intern;
+  st->roottext    = false;
+  st->spans       = true;
+  st->offset      = 0;
+}
+
+XML_INLINE
+xml_doc_t*
+xml__state_finish(xml__state_t * __restrict st) {
+  xml_doc_t *doc;
+  xml_t     *root, *obj;
+
+  doc = st->doc;
+
+  if (st->obj != st->root)
+    xml__error(doc, XML_ERR_UNCLOSED, st->offset, "end tag");
+  else if (!st->root->val)
+    xml__error(doc, XML_ERR_EOF, st->offset, "root element");
+
+  /* close open elements like end tags, partial tree must be valid to walk */
+  obj = st->obj;
+  while (obj && obj != st->root) {
+    obj->exact = false;
+    obj        = xml__close(obj, st->reverse);
+  }
 
-        goto again;
-      case '<': { /* TODO: what if we get << or <<!--  ->TAG>... here? */
-        if (pos == begintag)
+  st->obj = st->root;
+
+  /* don't return partial tree, keep only one page for reuse */
+  if (doc->error.code != XML_OK && doc->failfast) {
+    xml__mem_release(doc);
+    doc->root       = NULL;
+    doc->atoms      = NULL;
+    doc->lookups    = NULL;
+    doc->lookupmask = 0;
+    doc->nlookups   = 0;
+    return doc;
+  }
+
+  if ((root = st->root->val)) {
+    root->parent = NULL;
+    root->next   = NULL;
+  }
+
+  doc->root = root;
+  return doc;
+}
+
+/*!
+ * @brief parse [p, pend) and continue to build tree from state
+ *
+ * @return false on error, state is not valid to resume after error
+ */
+XML_STATIC
+bool
+xml__parse_run(xml__state_t * __restrict st,
+               char         * __restrict p,
+               char         * __restrict pend) {
+  xml_doc_t    *doc;
+  xml_t        *obj, *val, *tmproot, *notext;
+  xml_attr_t   *attr, **tail;
+  xml__index_t  idx;
+  const char       *expected;
+  char             *start, *q, c;
+  xml_type_t        type;
+  xml_error_code_t  code;
+  uint32_t          nattrs;
+  bool              reverse, sepPrefixes, readonly, comments, intern, spans;
+  bool              amp;
+
+  doc         = st->doc;
+  start       = p;
+  tmproot     = st->root;
+  notext      = st->roottext ? NULL : tmproot;
+  obj         = st->obj;
+  reverse     = st->reverse;
+  sepPrefixes = st->sepPrefixes;
+  readonly    = st->readonly;
+  comments    = st->comments;
+  intern      = st->intern;
+  spans       = st->spans;
+
+  xml__index_init(&idx, p, pend);
+
+  for (;;) {
+    /*
+     * text until next tag, whitespace-only runs are ignored. In partial parse
+     * (roottext), text until end is complete if it is under temporary root.
+     */
+    amp = false;
+    q   = (char *)xml__index_find_amp(&idx, p, '<', &amp);
+
+    if (q > p
+        && obj != notext
+        && (q < pend || obj == tmproot)
+        && xml__skip_space(p, q) < q) {
+      if (!(val = xml__impl_calloc(doc, sizeof(xml_t))))
+        goto nomem;
+
+      val->type     = XML_STRING;
+      val->readonly = readonly;
+      val->reverse  = reverse;
+      val->entity   = amp;
+      val->val      = p;
+      val->valsize  = (uint32_t)(q - p);
+
+      xml__link(obj, val, reverse);
+    } else if (q > p) {
+      obj->exact = false;
+    }
+
+    if (q >= pend)
+      break;
+
+    if (!readonly)
+      *q = '\0';
+
+    if ((p = q + 1) >= pend) {
+      expected = "tag name";
+      goto eof;
+    }
+
+    switch (*p) {
+      case '/': /* end tag */
+        p++;
+        if (obj == tmproot || !obj->tag) {
+          code     = XML_ERR_END_TAG;
+          expected = "start tag";
+          p        = q;
           goto err;
+        }
 
-        pos = begintag;
-        
-        if (!readonly) {
-          *p = '\0';
-          if ((c = *++p) != '\0')
-            goto again;;
+        if (sepPrefixes && obj->prefix && obj->prefixsize > 0) {
+          if ((size_t)(pend - p) <= obj->prefixsize) {
+            expected = "end tag";
+            goto eof;
+          }
+
+          if (!xml__bytes_eq(p, obj->prefix, obj->prefixsize)
+              || p[obj->prefixsize] != ':') {
+            code     = XML_ERR_END_TAG;
+            expected = "matching end tag";
+            p        = q;
+            goto err;
+          }
+
+          p += obj->prefixsize + 1;
         }
-        break;
-      }
-      case '!': { /* Comment + CTADA */
-        char c1, c2;
-        
-        /* comments, skip for now. */
-        if (p[1] != '\0' && p[1] == '-' && p[2] == '-') {
-          p  = p + 2;
-          c  = *p;
-          c2 = '\0';
-
-          do {
-            if (c == '\0')
-              goto err;
-
-            c1 = c2;
-            c2 = c;
-            c  = *++p;
-            
-          } while (!(c1 == '-' && c2 == '-' && c == '>'));
-
-          pos = beginel;
+
+        if ((size_t)(pend - p) <= obj->tagsize) {
+          expected = "end tag";
+          goto eof;
         }
-        
-        /* CDATA or similar data, skip for now. */
-        else if (p[1] != '\0' && p[1] == '[') {
-          p  = p + 2;
-          c  = *p;
-          c2 = '\0';
-          
-          do {
-            if (c == '\0')
-              goto err;
-
-            c1 = c2;
-            c2 = c;
-            c  = *++p;
-
-          } while (!(c1 == ']' && c2 == ']' && c == '>')
-                   && !(c1 == ']' && c2 == ' ' && c == '>'));
-
-          pos = beginel;
+
+        if (!xml__bytes_eq(p, obj->tag, obj->tagsize)) {
+          code     = XML_ERR_END_TAG;
+          expected = "matching end tag";
+          p        = q;
+          goto err;
         }
-        break;
-      }
+
+        p = (char *)xml__skip_space(p + obj->tagsize, pend);
+        if (p >= pend || *p != '>') {
+          code     = XML_ERR_SYNTAX;
+          expected = ">";
+          goto err;
+        }
+
+        if (!readonly)
+          *p = '\0';
+
+        p++;
+        obj = xml__close(obj, reverse);
+        continue;
+      case '!':
       case '?':
-        /* skip XML header e.g. version line */
-        if (pos == begintag) {
-          /* skip to value  */
-          while (c != '>') {
-            if (c == '\0')
-              goto err;
-            c = *++p;
+        /* CDATA and comments are nodes, payload is a span in input */
+        type = *p == '!' ? xml__section(p, pend) : XML_UNKOWN;
+        if (type == XML_CDATA || (type == XML_COMMENT && comments)) {
+          expected = type == XML_CDATA ? "]]>" : "-->";
+          p       += type == XML_CDATA ? 8 : 3;
+          if (!(q = xml__section_end(p, pend, type == XML_CDATA ? ']' : '-')))
+            goto eof;
+
+          if (obj != notext) {
+            if (!(val = xml__impl_calloc(doc, sizeof(xml_t))))
+              goto nomem;
+
+            val->type     = type;
+            val->readonly = readonly;
+            val->reverse  = reverse;
+            val->val      = p;
+            val->valsize  = (uint32_t)(q - 2 - p);
+
+            xml__link(obj, val, reverse);
+
+            if (!readonly)
+              q[-2] = '\0';
           }
 
-          pos = 0;
+          p = q + 1;
+          continue;
         }
-        break;
-      case '/':
-        switch (pos) {
-          case begintag:
-            /* end xml tag */
-            tag = obj->tag;
-            c   = *++p;
-
-            if (sepPrefixes && obj->prefix && obj->prefixsize > 0) {
-              const char *prefix;
-              uint32_t    prefixsize;
-
-              prefix     = obj->prefix;
-              prefixsize = obj->prefixsize;
-              do {
-                if (c == '\0')
-                  goto err;
-
-                if (c != *prefix++)
-                  goto err;
-
-                c = *++p;
-              } while (--prefixsize > 0);
-
-              if (c != ':')
-                goto err;
-
-              c = *++p;
-            }
-            
-            do {
-              if (c == '\0')
-                goto err;
-              
-              if (!tag || c != *tag++)
-                goto err;
-              
-              c = *++p;
-            } while (c != ' ' && c != '>');
-            
-            s = p + 1;
-            p--;
-            pos = endtag;
-            break;
-          case beginel:
-          case beginattr:
-            pos = endtag;
-            break;
-          default:
-            break;
+
+        if (!(q = xml__skip_markup(&idx, p, pend))) {
+          if (*p == '?')
+            expected = "?>";
+          else if (type == XML_COMMENT)
+            expected = "-->";
+          else if (pend - p > 1 && p[1] == '[')
+            expected = "]]>";
+          else
+            expected = ">";
+          goto eof;
         }
 
+        /* skipped markup is not in tree, source of element differs */
+        obj->exact = false;
+        p          = q + 1;
+        continue;
+      default:
         break;
-      case '>':
-        if (pos == endtag) {
-          /* switch parent back */
-          if (!parent)
-            goto err;
-          
-          if (!reverse) {
-            obj->val  = obj->next;
-            obj->next = NULL;
-          }
-          
-          obj    = parent;
-          parent = parent->parent;
-          pos    = endel;
-        } else {
-          pos = beginel;
-        }
-        
-        if (!readonly) {
+    }
+
+    /* start tag, document is stored in front of root element */
+    val = obj;
+    if (!(obj = val != notext
+                ? xml__impl_calloc(doc, sizeof(xml_t))
+                : xml__root_calloc(doc))) {
+      obj = val;
+      goto nomem;
+    }
+
+    obj->type     = XML_ELEMENT;
+    obj->readonly = readonly;
+    obj->reverse  = reverse;
+    obj->exact    = spans;
+    obj->tag      = p;
+
+    xml__link(val, obj, reverse);
+
+    if ((p = (char *)xml__scan_name_end(p, pend)) >= pend) {
+      obj->tagsize = (uint16_t)(pend - obj->tag);
+      expected     = ">";
+      goto eof;
+    }
+
+    if (sepPrefixes) {
+      while ((q = memchr(obj->tag, ':', (size_t)(p - obj->tag)))) {
+        obj->prefix     = obj->tag;
+        obj->prefixsize = (uint32_t)(q - obj->prefix);
+        obj->tag        = q + 1;
+      }
+    }
+
+    obj->tagsize = (uint16_t)(p - obj->tag);
+
+    if (intern
+        && (!(obj->atom = xml__atom_intern(doc, obj->tag, obj->tagsize))
+            || (obj->prefix
+                && !xml__atom_intern(doc, obj->prefix, obj->prefixsize))))
+      goto nomem;
+
+    /* attributes, in document order unless reverse */
+    tail   = &obj->attr;
+    nattrs = 0;
+    c      = *p;
+    for (;;) {
+      if (xml__ascii_space(c)) {
+        if (!readonly)
           *p = '\0';
-          if ((c = *++p) != '\0')
-            goto again;;
+
+        if ((p = (char *)xml__skip_space(p + 1, pend)) >= pend) {
+          expected = ">";
+          goto eof;
         }
+
+        c = *p;
+      }
+
+      if ((c == '>' || c == '/')
+          && XML_ATTR_INDEX_MIN > 0
+          && nattrs >= XML_ATTR_INDEX_MIN)
+        xmla_index(doc, obj);
+
+      if (c == '>') {
+        if (!readonly)
+          *p = '\0';
+        p++;
         break;
-      default: {
-        switch (pos) {
-          case begintag:
-            /* switch parent */
-            parent        = obj;
-            obj           = xml__impl_calloc(doc, sizeof(xml_t));
-            obj->type     = XML_ELEMENT;
-            obj->readonly = readonly;
-            obj->reverse  = reverse;
-            
-            /* parent must not be NULL */
-            
-            if (!reverse) {
-              if (!parent->next)
-                parent->next = obj;
-              else
-                xml_xml(parent)->next = obj;
-            } else {
-              obj->next = parent->val;
-            }
-            
-            parent->val = obj;
-            obj->parent = parent;
-            obj->tag    = p;
-
-            do {
-              if (c == '\0')
-                goto err;
-              
-              if (sepPrefixes) {
-                if (c == ':') {
-                  obj->prefix     = obj->tag;
-                  obj->prefixsize = (uint32_t)(p - obj->prefix);
-                  obj->tag        = p + 1;
-                }
-              }
-
-              c = *++p;
-            } while (c != ' ' && c != '/' && c != '>');
-            
-            obj->tagsize = (int)(p - obj->tag);
-            
-            if (c == '>') {
-              pos = beginel;
-            } else if (c == '/') {
-              pos = endtag;
-              
-              if (!readonly) {
-                *p = '\0';
-                if ((c = *++p) != '\0')
-                  goto again;;
-              }
-            } else {
-              pos = beginattr;
-            }
-            
-            /*
-             TODO: obly opens if error is handled
-             if (c  == '\0')
-             goto err;
-             */
-            
-            s = p + 1;
-            p--;
-            break;
-          case beginattr:
-            attr = xml__impl_calloc(doc, sizeof(xml_attr_t));
-            
-            /* attrib key */
-            if ((foundQuote = (c == '"' || c == '\'' || c == '`'))) {
-              quote            = c;
-              attr->namequote  = c;
-              c                = *++p;
-            }
-
-            attr->name = end = p;
-            
-            if (foundQuote) {
-              char *quoteEnd;
-
-              quoteEnd = xml__find_quote(p, quote);
-              if (!quoteEnd)
-                goto err;
-
-              end = xml__rtrim_ascii(p, quoteEnd);
-              p   = quoteEnd + 1;
-              c   = *p;
-            } else {
-              while (c != '=') {
-                if (c == '\0')
-                  goto err;
-                
-                if (c != ' ' && c != '\r'  && c != '\n' && c != '\t')
-                  end = p + 1;
-                
-                c = *++p;
-              }
-            }
-            
-            attr->namesize = (int)(end - attr->name);
-            if (!readonly)
-              *end = '\0';
-
-            if (attr->name == NULL || c  == '\0')
-              goto err;
-            
-            /* attrib value */
-            
-            /* skip to value  */
-            while (c != '=') {
-              if (c == '\0')
-                goto err;
-              c = *++p;
-            }
-            
-            /* skip trailing equal */
-            c = *++p;
-
-            if ((foundQuote = (c == '"' || c == '\'' || c == '`'))) {
-              quote          = c;
-              attr->valquote = c;
-              c              = *++p;
-            }
-            
-            attr->val = end = p;
-            
-            if (foundQuote) {
-              char *quoteEnd;
-
-              quoteEnd = xml__find_quote(p, quote);
-              if (!quoteEnd)
-                goto err;
-
-              end = xml__rtrim_ascii(p, quoteEnd);
-              p   = quoteEnd + 1;
-            } else {
-              while (c != '>' && c != '/') {
-                if (c == '\0')
-                  goto err;
-                
-                if (c != ' ' && c != '\r' && c != '\n' && c != '\t')
-                  end = p + 1;
-                
-                c = *++p;
-              }
-            }
-            
-            attr->valsize = (int)(end - attr->val);
-            if (!readonly)
-              *end = '\0';
-
-            c          = *p;
-            attr->next = obj->attr;
-            obj->attr  = attr;
-            attr       = NULL;
-            s          = p + 1;
-            
-            goto again;
-          case beginel:
-          case endel:
-            val           = xml__impl_calloc(doc, sizeof(xml_t));
-            val->type     = XML_STRING;
-            
-            val->readonly = readonly;
-            val->reverse  = reverse;
-            
-            /* parent must not be NULL */
-
-            if (!reverse) {
-              if (!obj->next)
-                obj->next = val;
-               else
-                xml_xml(obj)->next = val;
-            } else {
-              val->next = obj->val;
-            }
-
-            obj->val    = val;
-            val->parent = obj;
-            val->val    = (void *)s;
-
-            p = strchr(p, '<');
-            if (!p)
-              goto err;
-            
-            val->valsize = (int)(p - (char *)s);
-            p--;
-            break;
-          default:
-            break;
+      }
+
+      if (c == '/') {
+        if (!readonly)
+          *p = '\0';
+
+        if ((p = (char *)xml__skip_space(p + 1, pend)) >= pend) {
+          expected = ">";
+          goto eof;
+        }
+
+        if (*p != '>') {
+          code     = XML_ERR_SYNTAX;
+          expected = ">";
+          goto err;
         }
+
+        p++;
+        obj = xml__close(obj, reverse);
         break;
-      } /* switch->default */
-    } /* switch */
-  } while ((c = *p) != '\0' && (c = *++p) != '\0');
-  
-err:
-  
-  if (attr)
-    memset(attr, 0, sizeof(xml_attr_t));
+      }
+
+      if (!(attr = xml__impl_calloc(doc, sizeof(xml_attr_t))))
+        goto nomem;
 
-  if (tmproot.val) {
-    ((xml_t *)tmproot.val)->parent = NULL;
-    ((xml_t *)tmproot.val)->next   = NULL;
+      if (!(q = xml__parse_attr(&idx, attr, p, pend, readonly, &c))) {
+        code     = XML_ERR_ATTR;
+        expected = "name=\"value\"";
+        goto err;
+      }
+
+      p = q;
+      nattrs++;
+
+      if (reverse) {
+        attr->next = obj->attr;
+        obj->attr  = attr;
+      } else {
+        *tail = attr;
+        tail  = &attr->next;
+      }
+    }
   }
-  
-  doc->root = tmproot.val;
-  return doc;
+
+  st->obj     = obj;
+  st->offset += (size_t)(pend - start);
+  return true;
+
+nomem:
+  code     = XML_ERR_NOMEM;
+  expected = NULL;
+  goto err;
+
+eof:
+  code = XML_ERR_EOF;
+  p    = pend;
+
+err:
+  st->obj = obj;
+  xml__error(doc, code, st->offset + (size_t)(p - start), expected);
+  return false;
+}
+
+XML_INLINE
+xml_doc_t*
+xml_parse_doc(xml_doc_t  * __restrict doc,
+              const char * __restrict contents,
+              size_t                  len,
+              xml_options_t           options) {
+  xml__state_t st;
+  xml_t        tmproot;
+
+  if (!doc || !contents || len == 0)
+    return NULL;
+
+  xml_doc_reset(doc);
+  xml__doc_options(doc, options);
+  doc->ptr = contents;
+
+  if (options & XML_PRESCAN)
+    xml__doc_prescan(doc, contents, len);
+
+  xml__state_init(&st, doc, &tmproot);
+  xml__parse_run(&st, (char *)contents, (char *)contents + len);
+
+  return xml__state_finish(&st);
+}
+
+XML_INLINE
+xml_doc_t*
+xml_parse_n(const char * __restrict contents,
+            size_t                   len,
+            xml_options_t            options) {
+  if (!contents || len == 0)
+    return NULL;
+
+  return xml_parse_doc(xml_doc_new(NULL), contents, len, options);
+}
+
+XML_INLINE
+xml_doc_t*
+xml_parse(const char * __restrict contents, xml_options_t options) {
+  if (!contents)
+    return NULL;
+
+  return xml_parse_n(contents, strlen(contents), options);
 }
 
 #endif /* xml_impl_parse_h */
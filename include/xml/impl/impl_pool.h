@@ -0,0 +1,124 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_pool_h
+#define xml_impl_pool_h
+
+#include "../pool.h"
+#include "impl_mem.h"
+
+/*!
+ * @brief bytes which are allocated for document and its pages
+ */
+XML_INLINE
+size_t
+xml__doc_memsize(const xml_doc_t * __restrict doc) {
+  const xml_mem_t *mem;
+  size_t           size;
+
+  size = sizeof(*doc);
+  for (mem = doc->memroot; mem; mem = mem->next)
+    size += sizeof(*mem) + mem->capacity;
+
+  for (mem = doc->memspare; mem; mem = mem->next)
+    size += sizeof(*mem) + mem->capacity;
+
+  return size;
+}
+
+XML_INLINE
+void
+xml_pool_init(xml_pool_t            * __restrict pool,
+              size_t                             maxmem,
+              const xml_allocator_t * __restrict allocator) {
+  memset(pool, 0, sizeof(*pool));
+  pool->maxmem = maxmem;
+
+  if (allocator && allocator->alloc && allocator->free) {
+    pool->allocator = *allocator;
+    pool->hasalloc  = true;
+  }
+}
+
+XML_INLINE
+xml_doc_t*
+xml_pool_parse(xml_pool_t * __restrict pool,
+               const char * __restrict contents,
+               size_t                  len,
+               xml_options_t           options) {
+  xml_doc_t *doc;
+
+  if (!pool || !contents || len == 0)
+    return NULL;
+
+  if ((doc = pool->free)) {
+    pool->free    = doc->poolnext;
+    doc->poolnext = NULL;
+
+    pool->stats.retained -= xml__doc_memsize(doc);
+    pool->stats.count--;
+    pool->stats.hits++;
+  } else {
+    if (!(doc = xml_doc_new(pool->hasalloc ? &pool->allocator : NULL)))
+      return NULL;
+
+    pool->stats.misses++;
+  }
+
+  doc->atombase = pool->atombase;
+  return xml_parse_doc(doc, contents, len, options);
+}
+
+XML_INLINE
+void
+xml_pool_release(xml_pool_t * __restrict pool, xml_doc_t * __restrict doc) {
+  size_t size;
+
+  if (!pool || !doc)
+    return;
+
+  xml_doc_reset(doc);
+  size = xml__doc_memsize(doc);
+
+  if (pool->maxmem && pool->stats.retained + size > pool->maxmem) {
+    /* keep only current page */
+    xml__mem_free(doc, doc->memspare);
+    doc->memspare = NULL;
+
+    size = xml__doc_memsize(doc);
+    if (pool->stats.retained + size > pool->maxmem) {
+      xml_free(doc);
+      pool->stats.dropped++;
+      return;
+    }
+  }
+
+  doc->poolnext = pool->free;
+  pool->free    = doc;
+
+  pool->stats.retained += size;
+  pool->stats.count++;
+}
+
+XML_INLINE
+void
+xml_pool_destroy(xml_pool_t * __restrict pool) {
+  xml_doc_t *doc;
+
+  if (!pool)
+    return;
+
+  while ((doc = pool->free)) {
+    pool->free = doc->poolnext;
+    xml_free(doc);
+  }
+
+  pool->stats.retained = 0;
+  pool->stats.count    = 0;
+}
+
+#endif /* xml_impl_pool_h */
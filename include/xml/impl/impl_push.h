@@ -0,0 +1,458 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Chunks are not parsed by stage 2 directly because a markup may be split
+ * between chunks. A small resumable lexer follows the markup grammar which
+ * stage 2 uses and finds the end of last complete markup in pending bytes.
+ * Bytes until there are copied to document's memory (nodes point to them)
+ * and parsed with xml__parse_run(), parser state (current element, so the
+ * open element stack through parent links) is kept in xml__state_t.
+ * Remaining bytes stay in pending buffer with lexer state.
+ */
+
+#ifndef xml_impl_push_h
+#define xml_impl_push_h
+
+#include "../push.h"
+#include "impl_mem.h"
+#include "impl_scan.h"
+#include "impl_parse.h"
+
+typedef enum xml__lex_kind_t {
+  XML__LEX_TEXT = 0,    /* text, looking for '<'                           */
+  XML__LEX_OPEN,        /* after '<', markup type is not known yet         */
+  XML__LEX_ENDTAG,      /* </...>                                          */
+  XML__LEX_COMMENT,     /* <!-- ... -->                                    */
+  XML__LEX_CDATA,       /* <![ ... ]]>                                     */
+  XML__LEX_PI,          /* <? ... ?>                                       */
+  XML__LEX_DECL,        /* <!DOCTYPE ...>                                  */
+  XML__LEX_DECL_SUBSET, /* <!DOCTYPE ... [ ... ]>                          */
+  XML__LEX_TAG_NAME,    /* <name                                           */
+  XML__LEX_TAG_ATTR,    /* between attributes                              */
+  XML__LEX_TAG_SLASH,   /* after '/' of self closing tag                   */
+  XML__LEX_ATTR_NAME,   /* unquoted attribute name                         */
+  XML__LEX_ATTR_QNAME,  /* quoted attribute name                           */
+  XML__LEX_ATTR_EQ,     /* after quoted attribute name, expecting '='      */
+  XML__LEX_ATTR_VSPACE, /* after '='                                       */
+  XML__LEX_ATTR_VAL,    /* unquoted attribute value                        */
+  XML__LEX_ATTR_QVAL    /* quoted attribute value                          */
+} xml__lex_kind_t;
+
+/* all positions are offsets in pending bytes */
+typedef struct xml__lex_t {
+  size_t          tok;   /* '<' of current markup                      */
+  size_t          pos;   /* resume position                            */
+  size_t          aux;   /* begin of quoted string or terminator scan  */
+  xml__lex_kind_t kind;
+  char            quote;
+} xml__lex_t;
+
+struct xml_parser_t {
+  xml__state_t st;
+  xml__lex_t   lex;
+  xml_t        root;  /* temporary root, see xml__state_t */
+  char        *buf;   /* pending bytes                    */
+  size_t       len;
+  size_t       cap;
+  bool         failed;
+};
+
+/*!
+ * @brief find '>' which closes a terminator e.g. "-->", "]]>", "?>"
+ *
+ * same rule as xml__index_close() but it works on raw bytes and it is bounded
+ * by end, so scanning can be resumed from any position.
+ */
+XML_INLINE
+const char*
+xml__lex_close(const char * __restrict p,
+               const char * __restrict begin,
+               const char * __restrict end,
+               char                    a,
+               char                    b) {
+  while ((p = xml__scan_byte(p, end, '>')) < end) {
+    if (p - begin >= (a ? 2 : 1) && p[-1] == b && (!a || p[-2] == a))
+      return p;
+    p++;
+  }
+
+  return end;
+}
+
+/*!
+ * @brief lex [lx->pos, len) and return end of last complete markup
+ *
+ * @param[in, out] lx  lexer state, it is resumed from lx->pos
+ * @param[in]      buf pending bytes, lx offsets are relative to buf
+ * @param[in]      len number of bytes in buf
+ * @return offset after last complete markup or 0 if there is no one
+ */
+XML_STATIC
+size_t
+xml__lex_run(xml__lex_t * __restrict lx,
+             const char * __restrict buf,
+             size_t                   len) {
+  const char *p, *q, *end;
+  size_t      last;
+  char        c;
+
+  p    = buf + lx->pos;
+  end  = buf + len;
+  last = 0;
+
+  for (;;) {
+    switch (lx->kind) {
+      case XML__LEX_TEXT:
+        if ((q = xml__scan_byte(p, end, '<')) >= end)
+          goto wait;
+
+        lx->tok  = (size_t)(q - buf);
+        lx->kind = XML__LEX_OPEN;
+        p        = q + 1;
+        continue;
+      case XML__LEX_OPEN:
+        q = buf + lx->tok + 1;
+        if (q >= end)
+          goto wait;
+
+        switch (*q) {
+          case '/':
+            lx->kind = XML__LEX_ENDTAG;
+            p        = q + 1;
+            break;
+          case '?':
+            lx->kind = XML__LEX_PI;
+            lx->aux  = lx->tok + 2;
+            p        = q + 1;
+            break;
+          case '!':
+            /* stage 2 looks at up to two bytes after '!' to decide */
+            if (end - q < 2 || (q[1] == '-' && end - q < 3))
+              goto wait;
+
+            if (q[1] == '-' && q[2] == '-') {
+              lx->kind = XML__LEX_COMMENT;
+              lx->aux  = lx->tok + 4;
+              p        = q + 3;
+            } else if (q[1] == '[') {
+              lx->kind = XML__LEX_CDATA;
+              lx->aux  = lx->tok + 3;
+              p        = q + 2;
+            } else {
+              lx->kind = XML__LEX_DECL;
+              p        = q;
+            }
+            break;
+          default:
+            lx->kind = XML__LEX_TAG_NAME;
+            p        = q;
+            break;
+        }
+        continue;
+      case XML__LEX_ENDTAG:
+        if ((p = xml__scan_byte(p, end, '>')) >= end)
+          goto wait;
+        goto markup;
+      case XML__LEX_COMMENT:
+        if ((p = xml__lex_close(p, buf + lx->aux, end, '-', '-')) >= end)
+          goto wait;
+        goto markup;
+      case XML__LEX_CDATA:
+        if ((p = xml__lex_close(p, buf + lx->aux, end, ']', ']')) >= end)
+          goto wait;
+        goto markup;
+      case XML__LEX_PI:
+        if ((p = xml__lex_close(p, buf + lx->aux, end, '\0', '?')) >= end)
+          goto wait;
+        goto markup;
+      case XML__LEX_DECL:
+        if ((p = xml__scan_byte(p, end, '>')) >= end)
+          goto wait;
+
+        /* skip internal subset if exists */
+        q = buf + lx->tok + 1;
+        if (!(q = memchr(q, '[', (size_t)(p - q))))
+          goto markup;
+
+        lx->kind = XML__LEX_DECL_SUBSET;
+        lx->aux  = (size_t)(q + 1 - buf);
+        p        = q + 1;
+        continue;
+      case XML__LEX_DECL_SUBSET:
+        if ((p = xml__lex_close(p, buf + lx->aux, end, '\0', ']')) >= end)
+          goto wait;
+        goto markup;
+      case XML__LEX_TAG_NAME:
+        if ((p = xml__scan_name_end(p, end)) >= end)
+          goto wait;
+
+        lx->kind = XML__LEX_TAG_ATTR;
+        continue;
+      case XML__LEX_TAG_ATTR:
+        if ((p = xml__skip_space(p, end)) >= end)
+          goto wait;
+
+        c = *p;
+        if (c == '>')
+          goto markup;
+
+        if (c == '/') {
+          lx->kind = XML__LEX_TAG_SLASH;
+          p++;
+        } else if (c == '"' || c == '\'' || c == '`') {
+          lx->kind  = XML__LEX_ATTR_QNAME;
+          lx->quote = c;
+          lx->aux   = (size_t)(++p - buf);
+        } else {
+          lx->kind = XML__LEX_ATTR_NAME;
+        }
+        continue;
+      case XML__LEX_TAG_SLASH:
+        if ((p = xml__skip_space(p, end)) >= end)
+          goto wait;
+
+        /* stage 2 will report the error if it is not '>' */
+        goto markup;
+      case XML__LEX_ATTR_NAME:
+        while (p < end && *p != '=' && *p != '<' && *p != '>')
+          p++;
+
+        if (p >= end)
+          goto wait;
+
+        if (*p != '=')
+          goto markup;
+
+        lx->kind = XML__LEX_ATTR_VSPACE;
+        p++;
+        continue;
+      case XML__LEX_ATTR_QNAME:
+      case XML__LEX_ATTR_QVAL:
+        for (;;) {
+          if ((p = xml__scan_byte(p, end, lx->quote)) >= end)
+            goto wait;
+
+          if (!xml__quote_escaped(buf + lx->aux, p))
+            break;
+
+          p++;
+        }
+
+        p++;
+        lx->kind = lx->kind == XML__LEX_ATTR_QNAME ? XML__LEX_ATTR_EQ
+                                                   : XML__LEX_TAG_ATTR;
+        continue;
+      case XML__LEX_ATTR_EQ:
+        if ((p = xml__skip_space(p, end)) >= end)
+          goto wait;
+
+        if (*p != '=')
+          goto markup;
+
+        lx->kind = XML__LEX_ATTR_VSPACE;
+        p++;
+        continue;
+      case XML__LEX_ATTR_VSPACE:
+        if ((p = xml__skip_space(p, end)) >= end)
+          goto wait;
+
+        c = *p;
+        if (c == '"' || c == '\'' || c == '`') {
+          lx->kind  = XML__LEX_ATTR_QVAL;
+          lx->quote = c;
+          lx->aux   = (size_t)(++p - buf);
+        } else {
+          lx->kind = XML__LEX_ATTR_VAL;
+        }
+        continue;
+      case XML__LEX_ATTR_VAL:
+        if ((p = xml__scan_name_end(p, end)) >= end)
+          goto wait;
+
+        lx->kind = XML__LEX_TAG_ATTR;
+        continue;
+    }
+
+  markup:
+    /* markup is complete (or malformed, stage 2 will report it) */
+    lx->kind = XML__LEX_TEXT;
+    last     = (size_t)(++p - buf);
+  }
+
+wait:
+  lx->pos = len;
+  return last;
+}
+
+/*!
+ * @brief copy [buf, buf + len) into document and parse it
+ */
+XML_INLINE
+bool
+xml__push_run(xml_parser_t * __restrict parser,
+              const char   * __restrict buf,
+              size_t                    len) {
+  char   *p;
+  size_t  size;
+
+  /* keep node allocations aligned after copied bytes */
+  size = (len + 8) & ~(size_t)7;
+  if (!(p = xml__impl_alloc(parser->st.doc, size))) {
+    xml__error(parser->st.doc, XML_ERR_NOMEM, parser->st.offset, NULL);
+    parser->failed = true;
+    return false;
+  }
+
+  memcpy(p, buf, len);
+  memset(p + len, 0, size - len);
+
+  if (!xml__parse_run(&parser->st, p, p + len))
+    parser->failed = true;
+
+  return !parser->failed;
+}
+
+/*!
+ * @brief make lexer offsets relative to n bytes after current base
+ */
+XML_INLINE
+void
+xml__lex_shift(xml__lex_t * __restrict lx, size_t n) {
+  lx->pos -= n;
+  lx->tok  = lx->tok > n ? lx->tok - n : 0;
+  lx->aux  = lx->aux > n ? lx->aux - n : 0;
+}
+
+XML_INLINE
+bool
+xml__push_append(xml_parser_t * __restrict parser,
+                 const char   * __restrict buf,
+                 size_t                    len) {
+  char   *tmp;
+  size_t  cap;
+
+  if (len == 0)
+    return true;
+
+  if (parser->len + len > parser->cap) {
+    cap = parser->cap ? parser->cap : 4096;
+    while (cap < parser->len + len)
+      cap *= 2;
+
+    if (!(tmp = realloc(parser->buf, cap)))
+      return false;
+
+    parser->buf = tmp;
+    parser->cap = cap;
+  }
+
+  memcpy(parser->buf + parser->len, buf, len);
+  parser->len += len;
+
+  return true;
+}
+
+XML_INLINE
+xml_parser_t*
+xml_parser_new(xml_options_t options) {
+  xml_parser_t *parser;
+  xml_doc_t    *doc;
+
+  if (!(parser = calloc(1, sizeof(*parser))))
+    return NULL;
+
+  if (!(doc = xml__doc_new(options))) {
+    free(parser);
+    return NULL;
+  }
+
+  xml__state_init(&parser->st, doc, &parser->root);
+
+  /* markups are copied in pieces, elements are not contiguous */
+  parser->st.spans = false;
+
+  return parser;
+}
+
+XML_INLINE
+bool
+xml_parser_feed(xml_parser_t * __restrict parser,
+                const char   * __restrict buf,
+                size_t                    len) {
+  size_t n;
+
+  if (!parser || parser->failed)
+    return false;
+
+  if (!buf || len == 0)
+    return true;
+
+  /* nothing is pending: lex the chunk in place, only copy the tail */
+  if (parser->len == 0) {
+    if ((n = xml__lex_run(&parser->lex, buf, len)) > 0
+        && !xml__push_run(parser, buf, n))
+      return false;
+
+    xml__lex_shift(&parser->lex, n);
+    if (!xml__push_append(parser, buf + n, len - n))
+      goto err;
+
+    return true;
+  }
+
+  if (!xml__push_append(parser, buf, len))
+    goto err;
+
+  if ((n = xml__lex_run(&parser->lex, parser->buf, parser->len)) > 0) {
+    if (!xml__push_run(parser, parser->buf, n))
+      return false;
+
+    xml__lex_shift(&parser->lex, n);
+    parser->len -= n;
+    memmove(parser->buf, parser->buf + n, parser->len);
+  }
+
+  return true;
+
+err:
+  parser->failed = true;
+  return false;
+}
+
+XML_INLINE
+xml_doc_t*
+xml_parser_finish(xml_parser_t * __restrict parser) {
+  xml_doc_t *doc;
+
+  if (!parser)
+    return NULL;
+
+  /* trailing text or incomplete markup, let stage 2 handle it like xml_parse */
+  if (!parser->failed && parser->len > 0)
+    xml__push_run(parser, parser->buf, parser->len);
+
+  doc = xml__state_finish(&parser->st);
+
+  free(parser->buf);
+  free(parser);
+
+  return doc;
+}
+
+XML_INLINE
+void
+xml_parser_free(xml_parser_t * __restrict parser) {
+  if (!parser)
+    return;
+
+  xml_free(parser->st.doc);
+  free(parser->buf);
+  free(parser);
+}
+
+#endif /* xml_impl_push_h */
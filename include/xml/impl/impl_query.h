@@ -0,0 +1,793 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Query is run as a set of states: bit i of a mask means steps[0, i) are
+ * matched by an ancestor-or-self, so the next element can be tried with
+ * steps[i]. Mask of an element is computed from mask of its parent only,
+ * masks of open elements are kept in a stack (one word per level), so both
+ * DOM iterator and stream use same transition and none of them allocates.
+ * Bit nsteps means that element is matched by whole query.
+ *
+ * Position predicates count matches per parent: pos[level][i] is number of
+ * children of element at level which passed name test of steps[i] and
+ * predicates before position predicate.
+ */
+
+#ifndef xml_impl_query_h
+#define xml_impl_query_h
+
+#include "../query.h"
+#include "impl_scan.h"
+#include "impl_token.h"
+#include "../util.h"
+
+enum {
+  XML__QUERY_EVAL  = 0, /* compute mask of node                */
+  XML__QUERY_ATTRS = 1, /* emit attributes of node             */
+  XML__QUERY_NEXT  = 2, /* move to first child or next node    */
+  XML__QUERY_END   = 3
+};
+
+/* element which is tested, DOM node or start tag in contents */
+typedef struct xml__query_elem_t {
+  const xml_t  *node;       /* NULL for stream                          */
+  const char   *prefix;
+  const char   *tag;
+  const char   *attrs;      /* stream: after tag name, attrs until '>'  */
+  xml__index_t *idx;        /* stream: index of tokenizer               */
+  uint32_t      prefixsize;
+  uint32_t      tagsize;
+} xml__query_elem_t;
+
+XML_INLINE
+bool
+xml__query_namechar(char c) {
+  switch (c) {
+    case '\0': case '/':  case '[':  case ']': case '@': case '=':
+    case '!':  case '\'': case '"':  case '*': case '(': case ')':
+      return false;
+    default:
+      return !xml__ascii_space(c);
+  }
+}
+
+XML_INLINE
+const char*
+xml__query_space(const char * __restrict p) {
+  while (xml__ascii_space(*p))
+    p++;
+  return p;
+}
+
+/*!
+ * @brief parse literal, 'x' or "x"
+ *
+ * @return position after closing quote or NULL
+ */
+XML_INLINE
+const char*
+xml__query_literal(xml_query_pred_t * __restrict pred,
+                   const char       * __restrict p) {
+  const char *q;
+
+  if (*p != '\'' && *p != '"')
+    return NULL;
+
+  if (!(q = strchr(p + 1, *p)))
+    return NULL;
+
+  pred->val     = p + 1;
+  pred->valsize = (uint32_t)(q - p - 1);
+  return q + 1;
+}
+
+/*!
+ * @brief parse predicate
+ *
+ * @param[out] pred predicate
+ * @param[in]  p    first byte after '['
+ * @return position after ']' or NULL
+ */
+XML_STATIC
+const char*
+xml__query_pred(xml_query_pred_t * __restrict pred,
+                const char       * __restrict p) {
+  const char *q;
+  uint64_t    pos;
+  bool        attr;
+
+  p = xml__query_space(p);
+
+  if (*p >= '0' && *p <= '9') {
+    for (pos = 0; *p >= '0' && *p <= '9'; p++) {
+      if ((pos = pos * 10 + (uint64_t)(*p - '0')) > UINT32_MAX)
+        return NULL;
+    }
+
+    if (!pos)
+      return NULL;
+
+    pred->kind = XML_QUERY_PRED_POS;
+    pred->pos  = (uint32_t)pos;
+  } else {
+    if ((attr = *p == '@'))
+      p++;
+
+    for (q = p; xml__query_namechar(*q); q++);
+    if (q == p)
+      return NULL;
+
+    pred->name     = p;
+    pred->namesize = (uint32_t)(q - p);
+    pred->kind     = attr ? XML_QUERY_PRED_ATTR : XML_QUERY_PRED_CHILD;
+
+    p = xml__query_space(q);
+    if (*p == '=' || (attr && p[0] == '!' && p[1] == '=')) {
+      if (*p == '=') {
+        pred->kind = attr ? XML_QUERY_PRED_ATTR_EQ : XML_QUERY_PRED_CHILD_EQ;
+        p++;
+      } else {
+        pred->kind = XML_QUERY_PRED_ATTR_NE;
+        p += 2;
+      }
+
+      if (!(p = xml__query_literal(pred, xml__query_space(p))))
+        return NULL;
+    }
+  }
+
+  p = xml__query_space(p);
+  return *p == ']' ? p + 1 : NULL;
+}
+
+/*!
+ * @brief parse name test of step, '*', "name" or "prefix:name"
+ *
+ * @return position after name test or NULL
+ */
+XML_INLINE
+const char*
+xml__query_nametest(xml_query_step_t * __restrict step,
+                    const char       * __restrict p) {
+  const char *q, *colon;
+
+  if (*p == '*')
+    return p + 1;
+
+  for (q = p; xml__query_namechar(*q); q++);
+  if (q == p)
+    return NULL;
+
+  if ((colon = memchr(p, ':', (size_t)(q - p)))) {
+    step->prefix     = p;
+    step->prefixsize = (uint32_t)(colon - p);
+    p                = colon + 1;
+  }
+
+  step->name     = p;
+  step->namesize = (uint32_t)(q - p);
+  return q;
+}
+
+XML_INLINE
+xml_query_t*
+xml_query_compile(const char * __restrict expr) {
+  xml_query_t      *query;
+  xml_query_step_t *step;
+  xml_query_pred_t *pred;
+  const char       *p, *q;
+  size_t            len;
+  uint32_t          npos;
+  bool              desc;
+
+  if (!expr)
+    return NULL;
+
+  len = strlen(expr);
+  if (!(query = calloc(1, sizeof(*query) + len + 1)))
+    return NULL;
+
+  memcpy(query->expr, expr, len + 1);
+
+  query->streamable = true;
+  desc              = false;
+  p                 = query->expr;
+
+  if (*p == '/') {
+    query->absolute = true;
+    if (*++p == '/') {
+      desc = true;
+      p++;
+    }
+  }
+
+  for (;;) {
+    if (*p == '@') {
+      /* '//' before attribute step: attributes of any descendant element */
+      if (desc) {
+        if (query->nsteps >= XML_QUERY_MAX_STEPS)
+          goto err;
+
+        step             = &query->steps[query->nsteps++];
+        step->descendant = true;
+      }
+
+      step = &query->attr;
+      if (*++p == '*') {
+        p++;
+      } else {
+        for (q = p; xml__query_namechar(*q); q++);
+        if (q == p)
+          goto err;
+
+        step->name     = p;
+        step->namesize = (uint32_t)(q - p);
+        p              = q;
+      }
+
+      /* attribute must be last step */
+      if (*p || !query->nsteps)
+        goto err;
+
+      query->hasattr = true;
+      break;
+    }
+
+    if (query->nsteps >= XML_QUERY_MAX_STEPS)
+      goto err;
+
+    step             = &query->steps[query->nsteps++];
+    step->descendant = desc;
+    step->pred       = query->npreds;
+
+    if (!(p = xml__query_nametest(step, p)))
+      goto err;
+
+    npos = 0;
+    while (*p == '[') {
+      if (query->npreds >= XML_QUERY_MAX_PREDS)
+        goto err;
+
+      pred = &query->preds[query->npreds++];
+      if (!(p = xml__query_pred(pred, p + 1)))
+        goto err;
+
+      switch (pred->kind) {
+        case XML_QUERY_PRED_POS:
+          /* [1][2] is not supported, one position per step */
+          if (npos++)
+            goto err;
+          query->haspos = true;
+          break;
+        case XML_QUERY_PRED_CHILD:
+        case XML_QUERY_PRED_CHILD_EQ:
+          query->streamable = false;
+          break;
+        default:
+          break;
+      }
+    }
+
+    step->npred = query->npreds - step->pred;
+
+    if (!*p)
+      break;
+
+    if (*p != '/')
+      goto err;
+
+    if ((desc = *++p == '/'))
+      p++;
+  }
+
+  return query;
+
+err:
+  free(query);
+  return NULL;
+}
+
+XML_INLINE
+void
+xml_query_free(xml_query_t * __restrict query) {
+  free(query);
+}
+
+/*!
+ * @brief next attribute in start tag, attr gets spans in contents
+ *
+ * attribute is parsed by tokenizer (xml__parse_attr()) with its index, so
+ * stream accepts same attributes as parser. Tokenizer parses attributes of
+ * start tag again after this, so cursor of index is moved back.
+ *
+ * @param[in]  idx  index of tokenizer, idx->end is end of contents
+ * @param[in]  p    position in start tag, after tag name or last attribute
+ * @param[out] attr attribute
+ * @return position after attribute or NULL if there is no more attribute
+ */
+XML_INLINE
+const char*
+xml__query_scan_attr(xml__index_t * __restrict idx,
+                     const char   * __restrict p,
+                     xml_attr_t   * __restrict attr) {
+  const char *base, *q;
+  uint32_t    cur;
+  char        c;
+
+  p = xml__skip_space(p, idx->end);
+  if (p >= idx->end || (c = *p) == '>' || c == '/')
+    return NULL;
+
+  base = idx->base;
+  cur  = idx->cur;
+  q    = xml__parse_attr(idx, attr, (char *)p, (char *)idx->end, true, &c);
+
+  /* cursor only skips checked positions, restart it if window is moved */
+  idx->cur = idx->base == base ? cur : 0;
+
+  return q;
+}
+
+XML_INLINE
+bool
+xml__query_attr(const xml__query_elem_t * __restrict elem,
+                const xml_query_pred_t  * __restrict pred,
+                const char             ** __restrict val,
+                size_t                  * __restrict valsize) {
+  const xml_attr_t *found;
+  const char       *p;
+  xml_attr_t        attr;
+
+  if (elem->node) {
+    if (!(found = xmla_sz(elem->node, pred->name, pred->namesize)))
+      return false;
+
+    *val     = found->val;
+    *valsize = found->valsize;
+    return true;
+  }
+
+  for (p = elem->attrs; (p = xml__query_scan_attr(elem->idx, p, &attr)); ) {
+    if (attr.namesize == pred->namesize
+        && xml__bytes_eq(attr.name, pred->name, pred->namesize)) {
+      *val     = attr.val;
+      *valsize = attr.valsize;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*!
+ * @brief true if first text of a child element with name is equal to literal
+ */
+XML_INLINE
+bool
+xml__query_child_eq(const xml_t            * __restrict node,
+                    const xml_query_pred_t * __restrict pred) {
+  const xml_t *child;
+
+  for (child = xml_elem_sz(node, pred->name, pred->namesize);
+       child;
+       child = xml_elem_next_sz(child, pred->name, pred->namesize)) {
+    if (xml_val_eqsz(xmls(child), pred->val, pred->valsize))
+      return true;
+  }
+
+  return false;
+}
+
+XML_INLINE
+bool
+xml__query_name(const xml_query_step_t  * __restrict step,
+                const xml__query_elem_t * __restrict elem) {
+  if (!step->name)
+    return true;
+
+  if (!step->prefix)
+    return elem->tagsize == step->namesize
+           && xml__bytes_eq(elem->tag, step->name, step->namesize);
+
+  /* prefix is separated with XML_PREFIXES, else it is part of tag */
+  if (elem->prefix)
+    return elem->prefixsize == step->prefixsize
+           && elem->tagsize == step->namesize
+           && xml__bytes_eq(elem->prefix, step->prefix, step->prefixsize)
+           && xml__bytes_eq(elem->tag, step->name, step->namesize);
+
+  return elem->tagsize == step->prefixsize + 1 + step->namesize
+         && xml__bytes_eq(elem->tag, step->prefix, elem->tagsize);
+}
+
+/*!
+ * @brief evaluate predicates of step in order
+ *
+ * @param[in]     query query
+ * @param[in]     step  step
+ * @param[in]     elem  element
+ * @param[in,out] count number of siblings which reached position predicate
+ */
+XML_INLINE
+bool
+xml__query_preds(const xml_query_t       * __restrict query,
+                 const xml_query_step_t  * __restrict step,
+                 const xml__query_elem_t * __restrict elem,
+                 uint32_t                * __restrict count) {
+  const xml_query_pred_t *pred, *end;
+  const char             *val;
+  size_t                  valsize;
+  bool                    found, eq;
+
+  pred = &query->preds[step->pred];
+  end  = pred + step->npred;
+
+  for (; pred < end; pred++) {
+    switch (pred->kind) {
+      case XML_QUERY_PRED_POS:
+        if (++*count != pred->pos)
+          return false;
+        break;
+      case XML_QUERY_PRED_ATTR:
+      case XML_QUERY_PRED_ATTR_EQ:
+      case XML_QUERY_PRED_ATTR_NE:
+        if (!(found = xml__query_attr(elem, pred, &val, &valsize)))
+          return false;
+
+        if (pred->kind == XML_QUERY_PRED_ATTR)
+          break;
+
+        eq = valsize == pred->valsize
+             && (!valsize || xml__bytes_eq(val, pred->val, valsize));
+        if (eq != (pred->kind == XML_QUERY_PRED_ATTR_EQ))
+          return false;
+        break;
+      case XML_QUERY_PRED_CHILD:
+        if (!elem->node || !xml_elem_sz(elem->node, pred->name, pred->namesize))
+          return false;
+        break;
+      case XML_QUERY_PRED_CHILD_EQ:
+        if (!elem->node || !xml__query_child_eq(elem->node, pred))
+          return false;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/*!
+ * @brief mask of element from mask of its parent
+ *
+ * @param[in] query query
+ * @param[in] mask  mask of parent
+ * @param[in] elem  element
+ * @param[in] pos   position counters of parent's children
+ */
+XML_INLINE
+uint32_t
+xml__query_match(const xml_query_t       * __restrict query,
+                 uint32_t                             mask,
+                 const xml__query_elem_t * __restrict elem,
+                 uint32_t                * __restrict pos) {
+  const xml_query_step_t *step;
+  uint32_t                i, out;
+
+  out = 0;
+  for (i = 0; i < query->nsteps && (mask >> i); i++) {
+    if (!(mask & (1u << i)))
+      continue;
+
+    step = &query->steps[i];
+    if (step->descendant)
+      out |= 1u << i;
+
+    if (xml__query_name(step, elem)
+        && xml__query_preds(query, step, elem, &pos[i]))
+      out |= 1u << (i + 1);
+  }
+
+  return out;
+}
+
+XML_INLINE
+bool
+xml__query_attr_name(const xml_query_t * __restrict query,
+                     const xml_attr_t  * __restrict attr) {
+  return !query->attr.name
+         || (attr->namesize == query->attr.namesize
+             && xml__bytes_eq(attr->name,
+                              query->attr.name,
+                              query->attr.namesize));
+}
+
+XML_INLINE
+void
+xml_query_begin(xml_query_iter_t  * __restrict it,
+                const xml_query_t * __restrict query,
+                xml_t             * __restrict ctx) {
+  it->query     = query;
+  it->node      = NULL;
+  it->attr      = NULL;
+  it->nextattr  = NULL;
+  it->level     = 1;
+  it->state     = XML__QUERY_END;
+  it->truncated = false;
+  it->mask[0]   = 1;
+
+  if (!query || !ctx)
+    return;
+
+  if (query->absolute) {
+    while (ctx->parent)
+      ctx = ctx->parent;
+
+    it->node = ctx->type == XML_ELEMENT ? ctx : NULL;
+  } else if (ctx->type == XML_ELEMENT) {
+    it->node = ctx->val;
+  }
+
+  if (it->node) {
+    it->state = XML__QUERY_EVAL;
+    memset(it->pos[0], 0, sizeof(it->pos[0]));
+  }
+}
+
+XML_INLINE
+xml_t*
+xml_query_next(xml_query_iter_t * __restrict it) {
+  const xml_query_t *query;
+  xml_t             *node;
+  xml__query_elem_t  elem;
+  xml_attr_t        *attr;
+  uint32_t           final, level;
+
+  query = it->query;
+  node  = it->node;
+  level = it->level;
+
+  if (!query)
+    return NULL;
+
+  final      = 1u << query->nsteps;
+  elem.attrs = NULL;
+  elem.idx   = NULL;
+
+  for (;;) {
+    switch (it->state) {
+      case XML__QUERY_EVAL:
+        if (node->type != XML_ELEMENT) {
+          it->mask[level] = 0;
+          it->state       = XML__QUERY_NEXT;
+          break;
+        }
+
+        elem.node       = node;
+        elem.prefix     = node->prefix;
+        elem.prefixsize = node->prefixsize;
+        elem.tag        = node->tag;
+        elem.tagsize    = node->tagsize;
+
+        it->mask[level] = xml__query_match(query,
+                                           it->mask[level - 1],
+                                           &elem,
+                                           it->pos[level - 1]);
+
+        if (!(it->mask[level] & final)) {
+          it->state = XML__QUERY_NEXT;
+          break;
+        }
+
+        if (query->hasattr) {
+          it->nextattr = node->attr;
+          it->state    = XML__QUERY_ATTRS;
+          break;
+        }
+
+        it->state = XML__QUERY_NEXT;
+        it->node  = node;
+        it->level = level;
+        return node;
+      case XML__QUERY_ATTRS:
+        while ((attr = it->nextattr)) {
+          it->nextattr = attr->next;
+          if (attr->name && xml__query_attr_name(query, attr)) {
+            it->node  = node;
+            it->attr  = attr;
+            it->level = level;
+            return node;
+          }
+        }
+
+        it->state = XML__QUERY_NEXT;
+        break;
+      case XML__QUERY_NEXT:
+        /* descend if a step can still match in subtree */
+        if (node->type == XML_ELEMENT && node->val
+            && (it->mask[level] & ~final)) {
+          if (level < XML_QUERY_MAX_DEPTH) {
+            if (query->haspos)
+              memset(it->pos[level], 0, sizeof(it->pos[level]));
+
+            node = node->val;
+            level++;
+            it->state = XML__QUERY_EVAL;
+            break;
+          }
+
+          it->truncated = true;
+        }
+
+        while (!node->next && level > 1) {
+          node = node->parent;
+          level--;
+        }
+
+        if (!(node = node->next)) {
+          it->state = XML__QUERY_END;
+          it->node  = NULL;
+          it->attr  = NULL;
+          return NULL;
+        }
+
+        it->state = XML__QUERY_EVAL;
+        break;
+      default:
+        return NULL;
+    }
+  }
+}
+
+XML_INLINE
+xml_t*
+xml_query_first(const xml_query_t * __restrict query, xml_t * __restrict ctx) {
+  xml_query_iter_t it;
+
+  xml_query_begin(&it, query, ctx);
+  return xml_query_next(&it);
+}
+
+XML_INLINE
+xml_attr_t*
+xml_query_first_attr(const xml_query_t * __restrict query,
+                     xml_t             * __restrict ctx) {
+  xml_query_iter_t it;
+
+  if (!query || !query->hasattr)
+    return NULL;
+
+  xml_query_begin(&it, query, ctx);
+  return xml_query_next(&it) ? it.attr : NULL;
+}
+
+XML_INLINE
+bool
+xml_query_stream_init(xml_query_stream_t * __restrict stream,
+                      const xml_query_t  * __restrict query,
+                      const char         * __restrict contents,
+                      size_t                          len,
+                      xml_options_t                   options) {
+  if (!query || !query->streamable || !contents)
+    return false;
+
+  stream->query      = query;
+  stream->prefix     = NULL;
+  stream->tag        = NULL;
+  stream->prefixsize = 0;
+  stream->tagsize    = 0;
+  stream->depth      = 0;
+  stream->attrp      = NULL;
+  stream->skip       = false;
+  stream->mask[0]    = 1;
+
+  memset(&stream->attr, 0, sizeof(stream->attr));
+  memset(stream->pos[0], 0, sizeof(stream->pos[0]));
+  xml__tok_init(&stream->tok, contents, len, options & XML_PREFIXES);
+
+  return true;
+}
+
+/*!
+ * @brief skip rest of current element, tokenizer is after its start tag
+ */
+XML_INLINE
+bool
+xml__query_skip(xml__tok_t * __restrict tok) {
+  xml__tok_kind_t t;
+  uint32_t        depth;
+
+  depth = tok->level - 1;
+  while ((t = xml__tok_next(tok)) != XML__TOK_END || tok->depth != depth) {
+    if (t <= XML__TOK_ERROR)
+      return false;
+  }
+
+  return true;
+}
+
+XML_INLINE
+xml_query_match_t
+xml_query_stream_next(xml_query_stream_t * __restrict stream) {
+  const xml_query_t *query;
+  xml__tok_t        *tok;
+  xml__query_elem_t  elem;
+  const char        *p;
+  xml__tok_kind_t    t;
+  uint32_t           final, level, mask;
+
+  query = stream->query;
+  tok   = &stream->tok;
+  final = 1u << query->nsteps;
+
+  for (;;) {
+    /* rest of attributes of last matched element */
+    if ((p = stream->attrp)) {
+      while ((p = xml__query_scan_attr(&tok->idx, p, &stream->attr))) {
+        if (xml__query_attr_name(query, &stream->attr)) {
+          stream->attrp = p;
+          return XML_QUERY_ATTR;
+        }
+      }
+
+      stream->attrp = NULL;
+    }
+
+    if (stream->skip) {
+      stream->skip = false;
+      if (!xml__query_skip(tok))
+        return XML_QUERY_ERROR;
+    }
+
+    if ((t = xml__tok_next(tok)) <= XML__TOK_ERROR)
+      return t == XML__TOK_EOF ? XML_QUERY_EOF : XML_QUERY_ERROR;
+
+    if (t != XML__TOK_START)
+      continue;
+
+    /* subtrees which can't match are skipped, so parent is active */
+    if ((level = tok->depth + 1) > XML_QUERY_MAX_DEPTH)
+      return XML_QUERY_ERROR;
+
+    elem.node       = NULL;
+    elem.prefix     = tok->prefix;
+    elem.prefixsize = tok->prefixsize;
+    elem.tag        = tok->tag;
+    elem.tagsize    = tok->tagsize;
+    elem.attrs      = tok->p;
+    elem.idx        = &tok->idx;
+
+    mask = xml__query_match(query,
+                            stream->mask[level - 1],
+                            &elem,
+                            stream->pos[level - 1]);
+
+    stream->mask[level] = mask;
+    stream->skip        = !(mask & ~final);
+
+    if (query->haspos && !stream->skip)
+      memset(stream->pos[level], 0, sizeof(stream->pos[level]));
+
+    if (!(mask & final))
+      continue;
+
+    stream->prefix     = tok->prefix;
+    stream->prefixsize = tok->prefixsize;
+    stream->tag        = tok->tag;
+    stream->tagsize    = tok->tagsize;
+    stream->depth      = tok->depth;
+
+    if (!query->hasattr)
+      return XML_QUERY_ELEM;
+
+    stream->attrp = tok->p;
+  }
+}
+
+#endif /* xml_impl_query_h */
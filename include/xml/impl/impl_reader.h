@@ -0,0 +1,92 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_reader_h
+#define xml_impl_reader_h
+
+#include "../reader.h"
+#include "impl_token.h"
+
+XML_INLINE
+void
+xml_reader_init(xml_reader_t * __restrict reader,
+                const char   * __restrict contents,
+                size_t                    len,
+                xml_options_t             options) {
+  memset(reader, 0, offsetof(xml_reader_t, tok));
+  if (!contents) {
+    contents = "";
+    len      = 0;
+  }
+
+  xml__tok_init(&reader->tok, contents, len, options & XML_PREFIXES);
+}
+
+XML_INLINE
+xml_token_t
+xml_reader_next(xml_reader_t * __restrict reader) {
+  xml__tok_t *tok;
+
+  tok = &reader->tok;
+
+  switch ((reader->token = (xml_token_t)xml__tok_next(tok))) {
+    case XML_TOKEN_START:
+    case XML_TOKEN_END:
+      reader->prefix     = tok->prefix;
+      reader->tag        = tok->tag;
+      reader->prefixsize = tok->prefixsize;
+      reader->tagsize    = tok->tagsize;
+      break;
+    case XML_TOKEN_ATTR:
+      reader->attr      = tok->attr;
+      reader->attr.next = NULL;
+      break;
+    case XML_TOKEN_TEXT:
+    case XML_TOKEN_CDATA:
+      reader->val     = tok->val;
+      reader->valsize = tok->valsize;
+      break;
+    default:
+      break;
+  }
+
+  reader->depth = tok->depth;
+  return reader->token;
+}
+
+XML_INLINE
+xml_token_t
+xml_reader_skip_subtree(xml_reader_t * __restrict reader) {
+  xml__tok_t      *tok;
+  xml__tok_kind_t  t;
+  uint32_t         depth;
+
+  if (reader->token != XML_TOKEN_START && reader->token != XML_TOKEN_ATTR)
+    return reader->token;
+
+  tok   = &reader->tok;
+  depth = reader->depth;
+
+  /* tokens are not copied to reader until END of the element */
+  while ((t = xml__tok_next(tok)) != XML__TOK_END || tok->depth != depth) {
+    if (t == XML__TOK_ERROR || t == XML__TOK_EOF) {
+      reader->token = XML_TOKEN_ERROR;
+      return XML_TOKEN_ERROR;
+    }
+  }
+
+  reader->token      = XML_TOKEN_END;
+  reader->prefix     = tok->prefix;
+  reader->tag        = tok->tag;
+  reader->prefixsize = tok->prefixsize;
+  reader->tagsize    = tok->tagsize;
+  reader->depth      = depth;
+
+  return XML_TOKEN_END;
+}
+
+#endif /* xml_impl_reader_h */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_sax_h
+#define xml_impl_sax_h
+
+#include "../sax.h"
+#include "impl_token.h"
+
+XML_INLINE
+bool
+xml_sax_attr_next(xml_sax_elem_t * __restrict elem,
+                  xml_attr_t     * __restrict attr) {
+  if (!elem || !elem->tok || !xml__tok_attr(elem->tok))
+    return false;
+
+  *attr      = elem->tok->attr;
+  attr->next = NULL;
+
+  return true;
+}
+
+XML_INLINE
+bool
+xml_sax_parse(const char      * __restrict contents,
+              size_t                       len,
+              xml_options_t                options,
+              const xml_sax_t * __restrict sax) {
+  xml__tok_t     tok;
+  xml_sax_elem_t elem;
+
+  if (!contents || !sax)
+    return false;
+
+  xml__tok_init(&tok, contents, len, options & XML_PREFIXES);
+
+  for (;;) {
+    switch (xml__tok_next(&tok)) {
+      case XML__TOK_START:
+        if (!sax->start)
+          break;
+
+        elem.prefix     = tok.prefix;
+        elem.tag        = tok.tag;
+        elem.prefixsize = tok.prefixsize;
+        elem.tagsize    = tok.tagsize;
+        elem.depth      = tok.depth;
+        elem.tok        = &tok;
+
+        if (!sax->start(sax->userdata, &elem))
+          return true;
+        break;
+      case XML__TOK_TEXT:
+      case XML__TOK_CDATA:
+        if (sax->text && !sax->text(sax->userdata, tok.val, tok.valsize))
+          return true;
+        break;
+      case XML__TOK_END:
+        if (!sax->end)
+          break;
+
+        elem.prefix     = tok.prefix;
+        elem.tag        = tok.tag;
+        elem.prefixsize = tok.prefixsize;
+        elem.tagsize    = tok.tagsize;
+        elem.depth      = tok.depth;
+        elem.tok        = NULL;
+
+        if (!sax->end(sax->userdata, &elem))
+          return true;
+        break;
+      case XML__TOK_ATTR: /* attributes which are not read in callback */
+        break;
+      case XML__TOK_EOF:
+        return true;
+      case XML__TOK_ERROR:
+      default:
+        return false;
+    }
+  }
+}
+
+#endif /* xml_impl_sax_h */
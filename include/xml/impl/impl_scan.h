@@ -0,0 +1,371 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Structural scanners used by parser to skip runs of bytes (text, whitespace,
+ * quoted values, names) in vector-sized strides. All scanners are bounded by
+ * `end` and never read past it, they return `end` if nothing is found.
+ *
+ * Kernels are selected at compile time: AVX2 (if compiled with -mavx2),
+ * SSE2 (x86-64 baseline), NEON (ARM64 / ARMv7 with NEON) otherwise scalar.
+ * Define XML_NO_SIMD to force scalar version.
+ */
+
+#ifndef xml_impl_scan_h
+#define xml_impl_scan_h
+
+#include "../common.h"
+
+#if !defined(XML_NO_SIMD)
+#  if defined(__AVX2__)
+#    define XML_SIMD_AVX2
+#    define XML_SIMD_SSE2
+#  elif defined(__SSE2__) || defined(_M_X64)                                  \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define XML_SIMD_SSE2
+#  elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#    define XML_SIMD_NEON
+#  endif
+#endif
+
+#if defined(XML_SIMD_AVX2)
+#  include <immintrin.h>
+#elif defined(XML_SIMD_SSE2)
+#  include <emmintrin.h>
+#elif defined(XML_SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
+#if defined(XML_SIMD_AVX2)
+
+#define XML__VW     32
+#define XML__VSHIFT 0
+
+typedef __m256i xml__v;
+
+XML_INLINE xml__v   xml__vload(const char *p) {
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+XML_INLINE xml__v   xml__veq(xml__v v, char c) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+XML_INLINE xml__v   xml__vor(xml__v a, xml__v b) { return _mm256_or_si256(a, b); }
+XML_INLINE uint64_t xml__vmask(xml__v v) {
+  return (uint32_t)_mm256_movemask_epi8(v);
+}
+XML_INLINE uint64_t xml__vnotmask(xml__v v) {
+  return ~(uint64_t)(uint32_t)_mm256_movemask_epi8(v) & 0xFFFFFFFFull;
+}
+XML_INLINE xml__v   xml__vzero(void) { return _mm256_setzero_si256(); }
+XML_INLINE xml__v   xml__vsub(xml__v a, xml__v b) {
+  return _mm256_sub_epi8(a, b);
+}
+XML_INLINE uint64_t xml__vsum(xml__v v) {
+  __m128i s;
+
+  v = _mm256_sad_epu8(v, _mm256_setzero_si256());
+  s = _mm_add_epi64(_mm256_castsi256_si128(v),
+                    _mm256_extracti128_si256(v, 1));
+  return (uint64_t)_mm_cvtsi128_si32(s)
+       + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+}
+
+#elif defined(XML_SIMD_SSE2)
+
+#define XML__VW     16
+#define XML__VSHIFT 0
+
+typedef __m128i xml__v;
+
+XML_INLINE xml__v   xml__vload(const char *p) {
+  return _mm_loadu_si128((const __m128i *)p);
+}
+XML_INLINE xml__v   xml__veq(xml__v v, char c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+XML_INLINE xml__v   xml__vor(xml__v a, xml__v b) { return _mm_or_si128(a, b); }
+XML_INLINE uint64_t xml__vmask(xml__v v) {
+  return (uint32_t)_mm_movemask_epi8(v);
+}
+XML_INLINE uint64_t xml__vnotmask(xml__v v) {
+  return ~(uint64_t)(uint32_t)_mm_movemask_epi8(v) & 0xFFFFull;
+}
+XML_INLINE xml__v   xml__vzero(void) { return _mm_setzero_si128(); }
+XML_INLINE xml__v   xml__vsub(xml__v a, xml__v b) { return _mm_sub_epi8(a, b); }
+XML_INLINE uint64_t xml__vsum(xml__v v) {
+  v = _mm_sad_epu8(v, _mm_setzero_si128());
+  return (uint64_t)_mm_cvtsi128_si32(v)
+       + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+}
+
+#elif defined(XML_SIMD_NEON)
+
+#define XML__VW     16
+#define XML__VSHIFT 2 /* 4 bits per byte in mask */
+
+typedef uint8x16_t xml__v;
+
+XML_INLINE xml__v   xml__vload(const char *p) {
+  return vld1q_u8((const uint8_t *)p);
+}
+XML_INLINE xml__v   xml__veq(xml__v v, char c) {
+  return vceqq_u8(v, vdupq_n_u8((uint8_t)c));
+}
+XML_INLINE xml__v   xml__vor(xml__v a, xml__v b) { return vorrq_u8(a, b); }
+XML_INLINE uint64_t xml__vmask(xml__v v) {
+  return vget_lane_u64(vreinterpret_u64_u8(
+           vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+XML_INLINE uint64_t xml__vnotmask(xml__v v) {
+  return ~xml__vmask(v);
+}
+XML_INLINE xml__v   xml__vzero(void) { return vdupq_n_u8(0); }
+XML_INLINE xml__v   xml__vsub(xml__v a, xml__v b) { return vsubq_u8(a, b); }
+XML_INLINE uint64_t xml__vsum(xml__v v) {
+  uint64x2_t s;
+
+  s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(v)));
+  return vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1);
+}
+
+#endif
+
+#if defined(XML__VW)
+#  define XML_SIMD
+XML_INLINE
+xml__v
+xml__vspace(xml__v v) {
+  return xml__vor(xml__vor(xml__veq(v, ' '),  xml__veq(v, '\n')),
+                  xml__vor(xml__veq(v, '\t'), xml__veq(v, '\r')));
+}
+#endif
+
+/*!
+ * @brief find first c in [p, end), returns end if not found
+ */
+XML_INLINE
+const char*
+xml__scan_byte(const char * __restrict p,
+               const char * __restrict end,
+               char                    c) {
+#if defined(XML_SIMD)
+  uint64_t m;
+
+  /* 4 vectors per iteration to skip long text runs */
+  for (; end - p >= 4 * XML__VW; p += 4 * XML__VW) {
+    xml__v v0, v1, v2, v3;
+
+    v0 = xml__veq(xml__vload(p),               c);
+    v1 = xml__veq(xml__vload(p + XML__VW),     c);
+    v2 = xml__veq(xml__vload(p + 2 * XML__VW), c);
+    v3 = xml__veq(xml__vload(p + 3 * XML__VW), c);
+
+    if (!xml__vmask(xml__vor(xml__vor(v0, v1), xml__vor(v2, v3))))
+      continue;
+
+    if ((m = xml__vmask(v0)))
+      return p + (xml__ctz64(m) >> XML__VSHIFT);
+    if ((m = xml__vmask(v1)))
+      return p + XML__VW + (xml__ctz64(m) >> XML__VSHIFT);
+    if ((m = xml__vmask(v2)))
+      return p + 2 * XML__VW + (xml__ctz64(m) >> XML__VSHIFT);
+
+    return p + 3 * XML__VW + (xml__ctz64(xml__vmask(v3)) >> XML__VSHIFT);
+  }
+
+  for (; end - p >= XML__VW; p += XML__VW) {
+    if ((m = xml__vmask(xml__veq(xml__vload(p), c))))
+      return p + (xml__ctz64(m) >> XML__VSHIFT);
+  }
+#endif
+
+  while (p < end && *p != c)
+    p++;
+
+  return p;
+}
+
+/*!
+ * @brief find first a or b in [p, end), returns end if not found
+ */
+XML_INLINE
+const char*
+xml__scan_byte2(const char * __restrict p,
+                const char * __restrict end,
+                char                    a,
+                char                    b) {
+#if defined(XML_SIMD)
+  uint64_t m;
+
+  for (; end - p >= XML__VW; p += XML__VW) {
+    xml__v v;
+
+    v = xml__vload(p);
+    if ((m = xml__vmask(xml__vor(xml__veq(v, a), xml__veq(v, b)))))
+      return p + (xml__ctz64(m) >> XML__VSHIFT);
+  }
+#endif
+
+  while (p < end && *p != a && *p != b)
+    p++;
+
+  return p;
+}
+
+/*!
+ * @brief find first a, b or c in [p, end), returns end if not found
+ */
+XML_INLINE
+const char*
+xml__scan_byte3(const char * __restrict p,
+                const char * __restrict end,
+                char                    a,
+                char                    b,
+                char                    c) {
+#if defined(XML_SIMD)
+  uint64_t m;
+
+  for (; end - p >= XML__VW; p += XML__VW) {
+    xml__v v;
+
+    v = xml__vload(p);
+    if ((m = xml__vmask(xml__vor(xml__vor(xml__veq(v, a), xml__veq(v, b)),
+                                 xml__veq(v, c)))))
+      return p + (xml__ctz64(m) >> XML__VSHIFT);
+  }
+#endif
+
+  while (p < end && *p != a && *p != b && *p != c)
+    p++;
+
+  return p;
+}
+
+/*!
+ * @brief skip whitespace run (' ', '\t', '\r', '\n'), returns first non-space
+ *        or end
+ */
+XML_INLINE
+const char*
+xml__skip_space(const char * __restrict p,
+                const char * __restrict end) {
+  /* most of the runs are single space, don't pay for vector setup */
+  if (p < end && !xml__ascii_space(*p))
+    return p;
+
+#if defined(XML_SIMD)
+  for (; end - p >= XML__VW; p += XML__VW) {
+    uint64_t m;
+
+    if ((m = xml__vnotmask(xml__vspace(xml__vload(p)))))
+      return p + (xml__ctz64(m) >> XML__VSHIFT);
+  }
+#endif
+
+  while (p < end && xml__ascii_space(*p))
+    p++;
+
+  return p;
+}
+
+/*!
+ * @brief find end of tag name: whitespace, '/' or '>'
+ */
+XML_INLINE
+const char*
+xml__scan_name_end(const char * __restrict p,
+                   const char * __restrict end) {
+#if defined(XML_SIMD)
+  for (; end - p >= XML__VW; p += XML__VW) {
+    xml__v   v;
+    uint64_t m;
+
+    v = xml__vload(p);
+    v = xml__vor(xml__vspace(v), xml__vor(xml__veq(v, '/'), xml__veq(v, '>')));
+    if ((m = xml__vmask(v)))
+      return p + (xml__ctz64(m) >> XML__VSHIFT);
+  }
+#endif
+
+  while (p < end && *p != '/' && *p != '>' && !xml__ascii_space(*p))
+    p++;
+
+  return p;
+}
+
+/*!
+ * @brief count a and b bytes in [p, end)
+ */
+XML_INLINE
+void
+xml__count_byte2(const char * __restrict p,
+                 const char * __restrict end,
+                 char                    a,
+                 char                    b,
+                 size_t     * __restrict na,
+                 size_t     * __restrict nb) {
+  size_t ca, cb;
+
+  ca = cb = 0;
+
+#if defined(XML_SIMD)
+  /*
+   * matches are accumulated in byte lanes (cmpeq gives 0xFF = -1), lanes are
+   * summed before they overflow: at most 255 vectors per round
+   */
+  while (end - p >= XML__VW) {
+    xml__v   va, vb, v;
+    unsigned k;
+
+    va = vb = xml__vzero();
+    for (k = 0; k < 255 && end - p >= XML__VW; k++, p += XML__VW) {
+      v  = xml__vload(p);
+      va = xml__vsub(va, xml__veq(v, a));
+      vb = xml__vsub(vb, xml__veq(v, b));
+    }
+
+    ca += (size_t)xml__vsum(va);
+    cb += (size_t)xml__vsum(vb);
+  }
+#endif
+
+  for (; p < end; p++) {
+    ca += *p == a;
+    cb += *p == b;
+  }
+
+  *na = ca;
+  *nb = cb;
+}
+
+/*!
+ * @brief find closing quote which is not escaped by backslash in [p, end)
+ *
+ * @param[in] p     first byte after opening quote
+ * @param[in] end   end of buffer
+ * @param[in] quote quote character
+ * @return position of quote or NULL if not found
+ */
+XML_INLINE
+char*
+xml__scan_quote(char * __restrict p,
+                char * __restrict end,
+                char              quote) {
+  char *begin, *found;
+
+  begin = p;
+  while ((found = (char *)xml__scan_byte(p, end, quote)) < end) {
+    if (!xml__quote_escaped(begin, found))
+      return found;
+
+    p = found + 1;
+  }
+
+  return NULL;
+}
+
+#endif /* xml_impl_scan_h */
@@ -0,0 +1,645 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef xml_impl_serialize_h
+#define xml_impl_serialize_h
+
+#include "../serialize.h"
+#include "impl_scan.h"
+
+#if defined(_WIN32)
+#  include <io.h>
+#else
+#  include <sys/types.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#  include <errno.h>
+#endif
+
+XML_INLINE
+void
+xml__writer_init(xml_writer_t * __restrict w, xml_sink_t sink) {
+  w->buf     = NULL;
+  w->len     = 0;
+  w->cap     = 0;
+  w->flushed = 0;
+  w->write   = NULL;
+  w->ctx     = NULL;
+  w->fd      = -1;
+  w->sink    = sink;
+  w->failed  = false;
+  w->niov    = 0;
+  w->seg     = 0;
+}
+
+XML_INLINE
+void
+xml_writer_mem(xml_writer_t * __restrict w, char * __restrict buf, size_t cap) {
+  xml__writer_init(w, buf ? XML_SINK_FIXED : XML_SINK_MEM);
+  if (buf) {
+    w->buf = buf;
+    w->cap = cap;
+  }
+}
+
+XML_INLINE
+bool
+xml_writer_fd(xml_writer_t * __restrict w, int fd) {
+  xml__writer_init(w, XML_SINK_FD);
+  w->fd = fd;
+
+  if (!(w->buf = malloc(XML_WRITER_BUFSIZE)))
+    return false;
+
+  w->cap = XML_WRITER_BUFSIZE;
+  return true;
+}
+
+XML_INLINE
+bool
+xml_writer_callback(xml_writer_t * __restrict w,
+                    xml_write_fn              write,
+                    void         * __restrict ctx) {
+  xml__writer_init(w, XML_SINK_WRITE);
+  w->write = write;
+  w->ctx   = ctx;
+
+  if (!(w->buf = malloc(XML_WRITER_BUFSIZE)))
+    return false;
+
+  w->cap = XML_WRITER_BUFSIZE;
+  return true;
+}
+
+XML_INLINE
+void
+xml_writer_free(xml_writer_t * __restrict w) {
+  if (w->sink != XML_SINK_FIXED)
+    free(w->buf);
+
+  w->buf = NULL;
+  w->len = w->cap = 0;
+}
+
+XML_INLINE
+size_t
+xml_writer_total(const xml_writer_t * __restrict w) {
+  return w->flushed + w->len;
+}
+
+/*!
+ * @brief write all spans, partial writes are continued
+ */
+XML_STATIC
+bool
+xml__writer_writev(int fd, xml_writer_span_t * __restrict spans, uint32_t n) {
+#if defined(_WIN32)
+  const char *p;
+  size_t      left;
+  int         r;
+  uint32_t    i;
+
+  for (i = 0; i < n; i++) {
+    p    = spans[i].data;
+    left = spans[i].len;
+    while (left > 0) {
+      r = _write(fd, p, left > 0x40000000 ? 0x40000000 : (unsigned)left);
+      if (r <= 0)
+        return false;
+
+      p    += r;
+      left -= (size_t)r;
+    }
+  }
+
+  return true;
+#else
+  struct iovec iov[XML_WRITER_IOV];
+  ssize_t      r;
+  size_t       done;
+  uint32_t     i, first;
+
+  for (i = 0; i < n; i++) {
+    iov[i].iov_base = (void *)spans[i].data;
+    iov[i].iov_len  = spans[i].len;
+  }
+
+  first = 0;
+  while (first < n) {
+    if ((r = writev(fd, iov + first, (int)(n - first))) < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    /* skip written buffers, continue from middle of partially written one */
+    done = (size_t)r;
+    while (first < n && done >= iov[first].iov_len)
+      done -= iov[first++].iov_len;
+
+    if (first < n) {
+      iov[first].iov_base  = (char *)iov[first].iov_base + done;
+      iov[first].iov_len  -= done;
+    }
+  }
+
+  return true;
+#endif
+}
+
+XML_INLINE
+bool
+xml_writer_flush(xml_writer_t * __restrict w) {
+  if (w->failed)
+    return false;
+
+  switch (w->sink) {
+    case XML_SINK_FD:
+      if (w->len > w->seg) {
+        w->iov[w->niov].data  = w->buf + w->seg;
+        w->iov[w->niov++].len = w->len - w->seg;
+      }
+
+      if (w->niov && !xml__writer_writev(w->fd, w->iov, w->niov))
+        w->failed = true;
+
+      w->flushed += w->len;
+      w->niov     = 0;
+      w->seg      = 0;
+      w->len      = 0;
+      break;
+    case XML_SINK_WRITE:
+      if (w->len && !w->write(w->ctx, w->buf, w->len))
+        w->failed = true;
+
+      w->flushed += w->len;
+      w->len      = 0;
+      break;
+    default:
+      break;
+  }
+
+  return !w->failed;
+}
+
+/*!
+ * @brief make space for len bytes in buf, buffer is flushed or grown
+ */
+XML_INLINE
+bool
+xml__writer_reserve(xml_writer_t * __restrict w, size_t len) {
+  char   *buf;
+  size_t  cap;
+
+  if (w->failed)
+    return false;
+
+  switch (w->sink) {
+    case XML_SINK_MEM:
+      for (cap = w->cap ? w->cap * 2 : 4096; cap - w->len < len; cap *= 2);
+      if (!(buf = realloc(w->buf, cap)))
+        break;
+
+      w->buf = buf;
+      w->cap = cap;
+      return true;
+    case XML_SINK_FD:
+    case XML_SINK_WRITE:
+      return xml_writer_flush(w);
+    default:
+      break;
+  }
+
+  w->failed = true;
+  return false;
+}
+
+XML_INLINE
+bool
+xml_write(xml_writer_t * __restrict w,
+          const char   * __restrict data,
+          size_t                    len) {
+  size_t n;
+
+  if (len <= w->cap - w->len) {
+    if (len) {
+      memcpy(w->buf + w->len, data, len);
+      w->len += len;
+    }
+    return true;
+  }
+
+  if (w->sink == XML_SINK_MEM) {
+    if (!xml__writer_reserve(w, len))
+      return false;
+
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+    return true;
+  }
+
+  /* fill and flush buffer, fixed sink fails when it is full */
+  while (len > 0) {
+    if ((n = w->cap - w->len) > len)
+      n = len;
+
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+    data   += n;
+    len    -= n;
+
+    if (len && !xml__writer_reserve(w, len))
+      return false;
+  }
+
+  return true;
+}
+
+/*!
+ * @brief write a value of tree, long values are referenced by fd sink
+ */
+XML_INLINE
+bool
+xml__writer_span(xml_writer_t * __restrict w,
+                 const char   * __restrict data,
+                 size_t                    len) {
+  if (w->sink != XML_SINK_FD || len < XML_WRITER_SPAN_MIN)
+    return xml_write(w, data, len);
+
+  /* staged bytes, span and staged bytes after it at flush */
+  if (w->failed || (w->niov + 3 > XML_WRITER_IOV && !xml_writer_flush(w)))
+    return false;
+
+  if (w->len > w->seg) {
+    w->iov[w->niov].data  = w->buf + w->seg;
+    w->iov[w->niov++].len = w->len - w->seg;
+    w->seg                = w->len;
+  }
+
+  w->iov[w->niov].data  = data;
+  w->iov[w->niov++].len = len;
+  w->flushed           += len;
+  return true;
+}
+
+/*
+ * serializer is written once for writing and counting: w is NULL while
+ * counting, functions are inlined so checks of w are folded.
+ */
+
+XML_INLINE
+bool
+xml__ser_put(xml_writer_t * __restrict w,
+             size_t       * __restrict total,
+             const char   * __restrict data,
+             size_t                    len) {
+  if (!w) {
+    *total += len;
+    return true;
+  }
+
+  return xml_write(w, data, len);
+}
+
+XML_INLINE
+bool
+xml__ser_span(xml_writer_t * __restrict w,
+              size_t       * __restrict total,
+              const char   * __restrict data,
+              size_t                    len) {
+  if (!w) {
+    *total += len;
+    return true;
+  }
+
+  return xml__writer_span(w, data, len);
+}
+
+XML_INLINE
+bool
+xml__ser_char(xml_writer_t * __restrict w,
+              size_t       * __restrict total,
+              char                      c) {
+  if (!w) {
+    (*total)++;
+    return true;
+  }
+
+  if (w->len < w->cap) {
+    w->buf[w->len++] = c;
+    return true;
+  }
+
+  return xml_write(w, &c, 1);
+}
+
+XML_INLINE
+bool
+xml__ser_indent(xml_writer_t * __restrict w,
+                size_t       * __restrict total,
+                size_t                    depth) {
+  static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+  size_t            n;
+
+  while (depth > 0) {
+    n = depth < sizeof(tabs) - 1 ? depth : sizeof(tabs) - 1;
+    if (!xml__ser_put(w, total, tabs, n))
+      return false;
+    depth -= n;
+  }
+
+  return true;
+}
+
+/*!
+ * @brief write prefix:tag
+ */
+XML_INLINE
+bool
+xml__ser_name(xml_writer_t * __restrict w,
+              size_t       * __restrict total,
+              const xml_t  * __restrict object) {
+  if (object->prefix
+      && (!xml__ser_put(w, total, object->prefix, object->prefixsize)
+          || !xml__ser_char(w, total, ':')))
+    return false;
+
+  return xml__ser_put(w, total, object->tag, object->tagsize);
+}
+
+/*!
+ * @brief write plain text with escaping '&', '<' and c ('>' or quote)
+ */
+XML_INLINE
+bool
+xml__ser_escape(xml_writer_t * __restrict w,
+                size_t       * __restrict total,
+                const char   * __restrict p,
+                size_t                    len,
+                char                      c) {
+  const char *end, *q, *ent;
+  size_t      entsize;
+
+  end = p + len;
+  for (;;) {
+    q = xml__scan_byte3(p, end, '&', '<', c);
+    if (q != p && !xml__ser_span(w, total, p, (size_t)(q - p)))
+      return false;
+
+    if (q == end)
+      return true;
+
+    switch (*q) {
+      case '&':  ent = "&amp;";  entsize = 5; break;
+      case '<':  ent = "&lt;";   entsize = 4; break;
+      case '>':  ent = "&gt;";   entsize = 4; break;
+      case '"':  ent = "&quot;"; entsize = 6; break;
+      case '\'': ent = "&apos;"; entsize = 6; break;
+      default:   ent = q;        entsize = 1; break;
+    }
+
+    if (!xml__ser_put(w, total, ent, entsize))
+      return false;
+
+    p = q + 1;
+  }
+}
+
+/*!
+ * @brief write value, plain text is escaped, raw value is written as it is
+ */
+XML_INLINE
+bool
+xml__ser_val(xml_writer_t * __restrict w,
+             size_t       * __restrict total,
+             const char   * __restrict val,
+             size_t                    len,
+             bool                      escape,
+             char                      c) {
+  if (!escape)
+    return xml__ser_span(w, total, val, len);
+
+  return xml__ser_escape(w, total, val, len, c);
+}
+
+XML_INLINE
+bool
+xml__ser_attrs(xml_writer_t * __restrict w,
+               size_t       * __restrict total,
+               const xml_t  * __restrict object,
+               bool                      escape) {
+  const xml_attr_t *a;
+  char              quote;
+
+  for (a = object->attr; a; a = a->next) {
+    quote = a->valquote ? (char)a->valquote : '"';
+
+    if (!xml__ser_char(w, total, ' ')
+        || (a->namequote && !xml__ser_char(w, total, (char)a->namequote))
+        || !xml__ser_put(w, total, a->name, a->namesize)
+        || (a->namequote && !xml__ser_char(w, total, (char)a->namequote))
+        || !xml__ser_char(w, total, '=')
+        || !xml__ser_char(w, total, quote)
+        || !xml__ser_val(w, total, a->val, a->valsize,
+                         escape || a->decoded, quote)
+        || !xml__ser_char(w, total, quote))
+      return false;
+  }
+
+  return true;
+}
+
+/*!
+ * @brief true if children of element are written on their own lines
+ *
+ * whitespace can't be added around text, so elements which have text or
+ * CDATA children are written inline.
+ */
+XML_INLINE
+bool
+xml__ser_block(const xml_t * __restrict object) {
+  const xml_t *child;
+
+  for (child = object->val; child; child = child->next) {
+    if (child->type != XML_ELEMENT && child->type != XML_COMMENT)
+      return false;
+  }
+
+  return true;
+}
+
+XML_STATIC
+bool
+xml__serialize(xml_writer_t * __restrict w,
+               size_t       * __restrict total,
+               const xml_t  * __restrict object,
+               int                       flags) {
+  const xml_t *node;
+  const char  *src;
+  size_t       depth, inl, srcsize;
+  bool         pretty, spans, escape, block;
+
+  pretty = flags & XML_SERIALIZE_PRETTY;
+  spans  = (flags & XML_SERIALIZE_SPANS) && !(flags & XML_SERIALIZE_PRETTY);
+  escape = flags & XML_SERIALIZE_ESCAPE;
+  node   = object;
+  depth  = 0;
+  inl    = 0; /* depth + 1 of element which children are inline, else 0 */
+
+  for (;;) {
+    block = pretty && !inl;
+    if (block && !xml__ser_indent(w, total, depth))
+      return false;
+
+    switch (node->type) {
+      case XML_ELEMENT:
+        /*
+         * unchanged subtree is copied from contents as it is, not in reversed
+         * trees since their lists are written in reverse order by the walk
+         */
+        if (spans
+            && node->readonly
+            && !node->reverse
+            && (src = xml_src(node, &srcsize))) {
+          if (!xml__ser_span(w, total, src, srcsize))
+            return false;
+          break;
+        }
+
+        if (!xml__ser_char(w, total, '<')
+            || !xml__ser_name(w, total, node)
+            || !xml__ser_attrs(w, total, node, escape))
+          return false;
+
+        if (!node->val) {
+          if (!xml__ser_put(w, total, "/>", 2))
+            return false;
+          break;
+        }
+
+        if (!xml__ser_char(w, total, '>'))
+          return false;
+
+        if (block) {
+          if (!xml__ser_block(node))
+            inl = depth + 1;
+          else if (!xml__ser_char(w, total, '\n'))
+            return false;
+        }
+
+        node = node->val;
+        depth++;
+        continue;
+      case XML_STRING:
+        if (!xml__ser_val(w, total, node->val, node->valsize,
+                          escape || node->decoded, '>'))
+          return false;
+        break;
+      case XML_CDATA:
+        if (!xml__ser_put(w, total, "<![CDATA[", 9)
+            || !xml__ser_span(w, total, node->val, node->valsize)
+            || !xml__ser_put(w, total, "]]>", 3))
+          return false;
+        break;
+      case XML_COMMENT:
+        if (!xml__ser_put(w, total, "<!--", 4)
+            || !xml__ser_span(w, total, node->val, node->valsize)
+            || !xml__ser_put(w, total, "-->", 3))
+          return false;
+        break;
+      default:
+        break;
+    }
+
+    if (block && !xml__ser_char(w, total, '\n'))
+      return false;
+
+    /* close elements until a sibling is found */
+    for (;;) {
+      if (node == object)
+        return true;
+
+      if (node->next)
+        break;
+
+      node = node->parent;
+      depth--;
+
+      if (pretty && !inl && !xml__ser_indent(w, total, depth))
+        return false;
+
+      if (!xml__ser_put(w, total, "</", 2)
+          || !xml__ser_name(w, total, node)
+          || !xml__ser_char(w, total, '>'))
+        return false;
+
+      if (inl == depth + 1)
+        inl = 0;
+
+      if (pretty && !inl && !xml__ser_char(w, total, '\n'))
+        return false;
+    }
+
+    node = node->next;
+  }
+}
+
+XML_INLINE
+bool
+xml_serialize(xml_writer_t * __restrict w,
+              const xml_t  * __restrict object,
+              int                       flags) {
+  if (!w || w->failed)
+    return false;
+
+  if (object && !xml__serialize(w, NULL, object, flags)) {
+    w->failed = true;
+    return false;
+  }
+
+  return xml_writer_flush(w);
+}
+
+XML_INLINE
+size_t
+xml_serialize_len(const xml_t * __restrict object, int flags) {
+  size_t total;
+
+  total = 0;
+  if (object)
+    xml__serialize(NULL, &total, object, flags);
+
+  return total;
+}
+
+XML_INLINE
+char*
+xml_serialize_str(const xml_t * __restrict object,
+                  int                      flags,
+                  size_t      * __restrict len) {
+  xml_writer_t w;
+  size_t       size;
+  char        *buf;
+
+  size = xml_serialize_len(object, flags);
+  if (!(buf = malloc(size + 1)))
+    return NULL;
+
+  xml_writer_mem(&w, buf, size);
+  if (!xml_serialize(&w, object, flags)) {
+    free(buf);
+    return NULL;
+  }
+
+  buf[w.len] = '\0';
+  if (len)
+    *len = w.len;
+
+  return buf;
+}
+
+#endif /* xml_impl_serialize_h */
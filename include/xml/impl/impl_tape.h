@@ -0,0 +1,386 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Tape is built from tokenizer (impl_token.h) in one pass. There is no
+ * element stack: while an element is open its link member stores index of
+ * parent's open element, it is replaced with distance to END when element is
+ * closed (similar to xml__close() for DOM).
+ */
+
+#ifndef xml_impl_tape_h
+#define xml_impl_tape_h
+
+#include "../tape.h"
+#include "impl_token.h"
+
+#define XML__TAPE_NONE UINT32_MAX
+
+XML_INLINE
+bool
+xml__tape_grow(xml_tape_t * __restrict tape, size_t * __restrict cap) {
+  xml_tape_node_t *nodes;
+
+  if (!(nodes = realloc(tape->nodes, *cap * 2 * sizeof(*nodes))))
+    return false;
+
+  tape->nodes = nodes;
+  *cap       *= 2;
+  return true;
+}
+
+/*!
+ * @brief write END node at i for open element
+ *
+ * @return index of parent's open element
+ */
+XML_INLINE
+uint32_t
+xml__tape_close(xml_tape_node_t * __restrict nodes,
+                uint32_t                     open,
+                uint32_t                     i) {
+  xml_tape_node_t *elem, *end;
+  uint32_t         parent;
+
+  elem   = &nodes[open];
+  end    = &nodes[i];
+  parent = elem->link;
+
+  end->off   = elem->off;
+  end->size  = elem->size;
+  end->extra = elem->extra;
+  end->type  = XML_TAPE_END;
+  end->flags = 0;
+  end->link  = elem->link = i - open;
+
+  return parent;
+}
+
+/*!
+ * @brief check that end tag matches with start tag of open element
+ */
+XML_INLINE
+bool
+xml__tape_end_eq(const xml_tape_node_t * __restrict elem,
+                 const char            * __restrict contents,
+                 const xml__tok_t      * __restrict tok) {
+  const char *tag;
+
+  tag = contents + elem->off;
+
+  /* self closing tag */
+  if (tok->tag == tag)
+    return true;
+
+  return tok->tagsize == elem->size
+         && tok->prefixsize == elem->extra
+         && xml__bytes_eq(tok->tag, tag, elem->size)
+         && (!elem->extra
+             || xml__bytes_eq(tok->prefix, tag - elem->extra - 1, elem->extra));
+}
+
+XML_INLINE
+xml_tape_t*
+xml_parse_tape(const char * __restrict contents,
+               size_t                   len,
+               xml_options_t            options) {
+  xml__tok_t       tok;
+  xml_tape_t      *tape;
+  xml_tape_node_t *node, *nodes;
+  xml__tok_kind_t  t;
+  size_t           cap;
+  uint32_t         i, open;
+
+  if (!contents || len == 0 || len >= UINT32_MAX)
+    return NULL;
+
+  if (!(tape = calloc(1, sizeof(*tape))))
+    return NULL;
+
+  cap = len / 16 + 16;
+  if (!(tape->nodes = malloc(cap * sizeof(*tape->nodes)))) {
+    free(tape);
+    return NULL;
+  }
+
+  tape->ptr         = contents;
+  tape->sepPrefixes = options & XML_PREFIXES;
+
+  xml__tok_init(&tok, contents, len, tape->sepPrefixes);
+
+  i    = 0;
+  open = XML__TAPE_NONE;
+
+  while ((t = xml__tok_next(&tok)) > XML__TOK_ERROR) {
+    /* keep one more node for XML_TAPE_EOF */
+    if (i + 1 >= cap && !xml__tape_grow(tape, &cap))
+      goto err;
+
+    node        = &tape->nodes[i];
+    node->flags = 0;
+
+    switch (t) {
+      case XML__TOK_START:
+        node->type  = XML_TAPE_ELEMENT;
+        node->off   = (uint32_t)(tok.tag - contents);
+        node->size  = tok.tagsize;
+        node->extra = (uint16_t)tok.prefixsize;
+        node->link  = open;
+        open        = i;
+        break;
+      case XML__TOK_ATTR:
+        node->type  = XML_TAPE_ATTR;
+        node->off   = (uint32_t)(tok.attr.name - contents);
+        node->size  = tok.attr.namesize;
+        node->extra = tok.attr.valsize;
+        node->link  = (uint32_t)(tok.attr.val - contents);
+        node->flags = tok.attr.entity ? XML_TAPE_ENTITY : 0;
+        break;
+      case XML__TOK_TEXT:
+        node->type  = XML_TAPE_TEXT;
+        node->off   = (uint32_t)(tok.val - contents);
+        node->size  = tok.valsize;
+        node->extra = 0;
+        node->link  = 0;
+        node->flags = tok.entity ? XML_TAPE_ENTITY : 0;
+        break;
+      case XML__TOK_CDATA:
+        node->type  = XML_TAPE_TEXT;
+        node->off   = (uint32_t)(tok.val - contents);
+        node->size  = tok.valsize;
+        node->extra = 0;
+        node->link  = 0;
+        node->flags = XML_TAPE_CDATA;
+        break;
+      case XML__TOK_END:
+        if (!xml__tape_end_eq(&tape->nodes[open], contents, &tok))
+          goto stop;
+
+        open = xml__tape_close(tape->nodes, open, i);
+        break;
+      default:
+        break;
+    }
+
+    i++;
+  }
+
+stop:
+  /* malformed document, close open elements to keep tape traversable */
+  while (open != XML__TAPE_NONE) {
+    if (i + 1 >= cap && !xml__tape_grow(tape, &cap))
+      goto err;
+
+    open = xml__tape_close(tape->nodes, open, i++);
+  }
+
+  memset(&tape->nodes[i], 0, sizeof(*tape->nodes));
+  tape->count = i;
+
+  /* give unused capacity back */
+  if (i + 1 < cap
+      && (nodes = realloc(tape->nodes, (i + 1) * sizeof(*tape->nodes))))
+    tape->nodes = nodes;
+
+  return tape;
+
+err:
+  free(tape->nodes);
+  free(tape);
+  return NULL;
+}
+
+XML_INLINE
+void
+xml_tape_free(xml_tape_t * __restrict tape) {
+  if (!tape)
+    return;
+
+  free(tape->nodes);
+  free(tape);
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_root(const xml_tape_t * __restrict tape) {
+  if (!tape || tape->nodes[0].type != XML_TAPE_ELEMENT)
+    return NULL;
+
+  return tape->nodes;
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_first(const xml_tape_node_t * __restrict node) {
+  if (!node || node->type != XML_TAPE_ELEMENT)
+    return NULL;
+
+  for (node++; node->type == XML_TAPE_ATTR; node++);
+
+  return node->type != XML_TAPE_END ? node : NULL;
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_next(const xml_tape_node_t * __restrict node) {
+  if (!node)
+    return NULL;
+
+  if (node->type == XML_TAPE_ELEMENT)
+    node += node->link;
+  else if (node->type != XML_TAPE_TEXT)
+    return NULL;
+
+  node++;
+  if (node->type != XML_TAPE_ELEMENT && node->type != XML_TAPE_TEXT)
+    return NULL;
+
+  return node;
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_skip(const xml_tape_node_t * __restrict node) {
+  if (node->type == XML_TAPE_ELEMENT)
+    return node + node->link + 1;
+
+  return node->type != XML_TAPE_EOF ? node + 1 : node;
+}
+
+XML_INLINE
+const char*
+xml_tape_str(const xml_tape_t      * __restrict tape,
+             const xml_tape_node_t * __restrict node) {
+  return tape->ptr + node->off;
+}
+
+XML_INLINE
+const char*
+xml_tape_prefix(const xml_tape_t      * __restrict tape,
+                const xml_tape_node_t * __restrict node) {
+  if (!node->extra
+      || (node->type != XML_TAPE_ELEMENT && node->type != XML_TAPE_END))
+    return NULL;
+
+  return tape->ptr + node->off - node->extra - 1;
+}
+
+XML_INLINE
+const char*
+xml_tape_val(const xml_tape_t      * __restrict tape,
+             const xml_tape_node_t * __restrict node) {
+  if (node->type != XML_TAPE_ATTR)
+    return NULL;
+
+  return tape->ptr + node->link;
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_attr(const xml_tape_t      * __restrict tape,
+              const xml_tape_node_t * __restrict node,
+              const char            * __restrict name) {
+  if (!name)
+    return NULL;
+
+  return xml_tape_attr_sz(tape, node, name, strlen(name));
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_attr_sz(const xml_tape_t      * __restrict tape,
+                 const xml_tape_node_t * __restrict node,
+                 const char            * __restrict name,
+                 size_t                              namesize) {
+  const char *ptr;
+
+  if (!tape || !node || !name || node->type != XML_TAPE_ELEMENT)
+    return NULL;
+
+  ptr = tape->ptr;
+  for (node++; node->type == XML_TAPE_ATTR; node++) {
+    if ((size_t)node->size == namesize
+        && (!namesize
+            || (ptr[node->off] == name[0]
+                && xml__bytes_eq(ptr + node->off, name, namesize))))
+      return node;
+  }
+
+  return NULL;
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem(const xml_tape_t      * __restrict tape,
+              const xml_tape_node_t * __restrict node,
+              const char            * __restrict name) {
+  if (!name)
+    return NULL;
+
+  return xml_tape_elem_sz(tape, node, name, strlen(name));
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem_sz(const xml_tape_t      * __restrict tape,
+                 const xml_tape_node_t * __restrict node,
+                 const char            * __restrict name,
+                 size_t                              namesize) {
+  const xml_tape_node_t *iter;
+
+  if (!tape || !name || !(iter = xml_tape_first(node)))
+    return NULL;
+
+  if (iter->type == XML_TAPE_ELEMENT
+      && (size_t)iter->size == namesize
+      && (!namesize
+          || (tape->ptr[iter->off] == name[0]
+              && xml__bytes_eq(tape->ptr + iter->off, name, namesize))))
+    return iter;
+
+  return xml_tape_elem_next_sz(tape, iter, name, namesize);
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem_next(const xml_tape_t      * __restrict tape,
+                   const xml_tape_node_t * __restrict current,
+                   const char            * __restrict name) {
+  if (!name)
+    return NULL;
+
+  return xml_tape_elem_next_sz(tape, current, name, strlen(name));
+}
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem_next_sz(const xml_tape_t      * __restrict tape,
+                      const xml_tape_node_t * __restrict current,
+                      const char            * __restrict name,
+                      size_t                              namesize) {
+  const xml_tape_node_t *iter;
+  const char            *ptr;
+
+  if (!tape || !name)
+    return NULL;
+
+  ptr  = tape->ptr;
+  iter = current;
+
+  while ((iter = xml_tape_next(iter))) {
+    if (iter->type == XML_TAPE_ELEMENT
+        && (size_t)iter->size == namesize
+        && (!namesize
+            || (ptr[iter->off] == name[0]
+                && xml__bytes_eq(ptr + iter->off, name, namesize))))
+      return iter;
+  }
+
+  return NULL;
+}
+
+#endif /* xml_impl_tape_h */
@@ -0,0 +1,448 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Markup grammar which is shared by tree construction (impl_parse.h) and by
+ * tokenizer (below) which builds no tree.
+ *
+ * Tokenizer returns one token at a time: start tag, attribute, text, end tag.
+ * It keeps only a fixed size state (structural index window and a cursor),
+ * it never allocates and never writes to the input. Tokens are spans in the
+ * input. Since there is no element stack, end tag names are not matched with
+ * start tags, only depth is tracked.
+ */
+
+#ifndef xml_impl_token_h
+#define xml_impl_token_h
+
+#include "../common.h"
+#include "impl_scan.h"
+#include "impl_index.h"
+
+/*!
+ * @brief separate prefix from tag name e.g. "p:tag" -> "p", "tag"
+ */
+XML_INLINE
+void
+xml__split_prefix(const char ** __restrict tag,
+                  const char ** __restrict prefix,
+                  uint32_t    * __restrict prefixsize,
+                  const char  * __restrict end) {
+  const char *q;
+
+  while ((q = memchr(*tag, ':', (size_t)(end - *tag)))) {
+    *prefix     = *tag;
+    *prefixsize = (uint32_t)(q - *prefix);
+    *tag        = q + 1;
+  }
+}
+
+/*!
+ * @brief find end of CDATA section or comment, '>' of "]]>" or "-->"
+ *
+ * payload is not indexed: '>' is searched with vector scanner, so large
+ * sections (scripts, escaped HTML...) are skipped in vector strides and
+ * characters like '<' or '&' in payload are never visited one by one.
+ *
+ * @param[in] begin first byte of payload
+ * @param[in] pend  end of input
+ * @param[in] c     ']' for CDATA, '-' for comment
+ * @return position of '>' or NULL if not found
+ */
+XML_INLINE
+char*
+xml__section_end(char * __restrict begin,
+                 char * __restrict pend,
+                 char              c) {
+  char *p;
+
+  p = begin;
+  while ((p = (char *)xml__scan_byte(p, pend, '>')) < pend) {
+    if (p - begin >= 2 && p[-1] == c && p[-2] == c)
+      return p;
+    p++;
+  }
+
+  return NULL;
+}
+
+/*!
+ * @brief type of <!...> markup which is kept as node
+ *
+ * @param[in] p    '!' after '<'
+ * @param[in] pend end of input
+ * @return XML_CDATA, XML_COMMENT or XML_UNKOWN for other markup e.g. DOCTYPE
+ */
+XML_INLINE
+xml_type_t
+xml__section(const char * __restrict p, const char * __restrict pend) {
+  if (pend - p > 2 && p[1] == '-' && p[2] == '-')
+    return XML_COMMENT;
+
+  if (pend - p > 7 && xml__bytes_eq(p + 1, "[CDATA[", 7))
+    return XML_CDATA;
+
+  return XML_UNKOWN;
+}
+
+/*!
+ * @brief find end of <!...> or <?...> markup
+ *
+ * comments, DOCTYPE (with internal subset) and processing instructions are
+ * skipped. CDATA in elements is returned as XML__TOK_CDATA by xml__tok_next(),
+ * only sections outside of root element are skipped here.
+ *
+ * @param[in] idx  index
+ * @param[in] p    '!' or '?' after '<'
+ * @param[in] pend end of input
+ * @return position of '>' or NULL if not found
+ */
+XML_INLINE
+char*
+xml__skip_markup(xml__index_t * __restrict idx,
+                 char         * __restrict p,
+                 char         * __restrict pend) {
+  char *q, *end;
+
+  /* skip XML header e.g. version line */
+  if (*p == '?')
+    return xml__index_close(idx, p + 1, '\0', '?');
+
+  /* comments */
+  if (pend - p > 2 && p[1] == '-' && p[2] == '-')
+    return xml__section_end(p + 3, pend, '-');
+
+  /* CDATA or similar data */
+  if (pend - p > 1 && p[1] == '[')
+    return xml__section_end(p + 2, pend, ']');
+
+  /* DOCTYPE or other declarations, skip internal subset if exists */
+  if ((q = (char *)xml__index_find(idx, p, '>')) >= pend)
+    return NULL;
+
+  if ((end = memchr(p, '[', (size_t)(q - p))))
+    return xml__index_close(idx, end + 1, '\0', ']');
+
+  return q;
+}
+
+/*!
+ * @brief parse one attribute: name = value
+ *
+ * name and value are trimmed, quotes are stored in namequote / valquote.
+ *
+ * @param[in]  idx      index
+ * @param[out] attr     attribute, next member is not touched
+ * @param[in]  p        first byte of attribute
+ * @param[in]  pend     end of input
+ * @param[in]  readonly don't write null terminators
+ * @param[out] delim    byte after attribute, it may be overwritten in input
+ * @return position of delim or NULL on error
+ */
+XML_INLINE
+char*
+xml__parse_attr(xml__index_t * __restrict idx,
+                xml_attr_t   * __restrict attr,
+                char         * __restrict p,
+                char         * __restrict pend,
+                bool                      readonly,
+                char         * __restrict delim) {
+  char *q, *end, c;
+  bool  amp;
+
+  amp = false;
+
+  /* attrib key */
+  c = *p;
+  if (c == '"' || c == '\'' || c == '`') {
+    attr->namequote = c;
+    attr->name      = ++p;
+
+    if (!(q = xml__index_quote(idx, p, c, &amp)))
+      return NULL;
+
+    end = xml__rtrim_ascii(p, q);
+    p   = (char *)xml__skip_space(q + 1, pend);
+    amp = false;
+
+    if (p >= pend || *p != '=')
+      return NULL;
+  } else {
+    attr->namequote = 0;
+    attr->name      = end = p;
+
+    /* name must end with '=' */
+    while ((p = (char *)xml__index_next(idx, p)) < pend && *p != '=') {
+      if (*p == '<' || *p == '>')
+        return NULL;
+      p++;
+    }
+
+    if (p >= pend)
+      return NULL;
+
+    end = xml__rtrim_ascii(end, p);
+  }
+
+  attr->namesize = (uint16_t)(end - attr->name);
+  if (!readonly)
+    *end = '\0';
+
+  /* attrib value */
+  if ((p = (char *)xml__skip_space(p + 1, pend)) >= pend)
+    return NULL;
+
+  c = *p;
+  if (c == '"' || c == '\'' || c == '`') {
+    attr->valquote = c;
+    attr->val      = ++p;
+
+    if (!(q = xml__index_quote(idx, p, c, &amp)))
+      return NULL;
+
+    end = xml__rtrim_ascii(p, q);
+    if ((p = q + 1) >= pend)
+      return NULL;
+
+    c = *p;
+  } else {
+    /* unquoted value, delim keeps the delimiter even if it is overwritten */
+    attr->valquote = 0;
+    attr->val      = p;
+    if ((p = (char *)xml__scan_name_end(p, pend)) >= pend)
+      return NULL;
+
+    end = p;
+    c   = *p;
+    amp = memchr(attr->val, '&', (size_t)(end - attr->val)) != NULL;
+  }
+
+  attr->valsize = (uint16_t)(end - attr->val);
+  attr->entity  = amp;
+  if (!readonly)
+    *end = '\0';
+
+  *delim = c;
+  return p;
+}
+
+typedef enum xml__tok_kind_t {
+  XML__TOK_EOF   = 0, /* end of input                                  */
+  XML__TOK_ERROR = 1, /* malformed input                               */
+  XML__TOK_START = 2, /* start tag, attributes are returned after this */
+  XML__TOK_ATTR  = 3, /* attribute of last start tag                   */
+  XML__TOK_TEXT  = 4, /* text, whitespace-only runs are skipped        */
+  XML__TOK_END   = 5, /* end tag or end of self closing tag            */
+  XML__TOK_CDATA = 6  /* payload of CDATA section, it is not decoded   */
+} xml__tok_kind_t;
+
+typedef struct xml__tok_t {
+  xml__index_t idx;
+  const char  *p;           /* cursor                                 */
+  const char  *pend;        /* end of input                           */
+  const char  *tag;         /* tag of START / END                     */
+  const char  *prefix;      /* prefix of START / END                  */
+  const char  *val;         /* TEXT, CDATA                            */
+  xml_attr_t   attr;        /* ATTR                                   */
+  uint32_t     tagsize;
+  uint32_t     prefixsize;
+  uint32_t     valsize;
+  uint32_t     depth;       /* depth of current token, root is 0      */
+  uint32_t     level;       /* number of open elements                */
+  bool         intag;       /* cursor is in start tag (attributes)    */
+  bool         entity;      /* TEXT contains '&'                      */
+  bool         sepPrefixes;
+} xml__tok_t;
+
+XML_INLINE
+void
+xml__tok_init(xml__tok_t  * __restrict tok,
+              const char  * __restrict contents,
+              size_t                   len,
+              bool                     sepPrefixes) {
+  tok->p           = contents;
+  tok->pend        = contents + len;
+  tok->tag         = NULL;
+  tok->prefix      = NULL;
+  tok->val         = NULL;
+  tok->tagsize     = 0;
+  tok->prefixsize  = 0;
+  tok->valsize     = 0;
+  tok->depth       = 0;
+  tok->level       = 0;
+  tok->intag       = false;
+  tok->entity      = false;
+  tok->sepPrefixes = sepPrefixes;
+
+  memset(&tok->attr, 0, sizeof(tok->attr));
+  xml__index_init(&tok->idx, contents, tok->pend);
+}
+
+/*!
+ * @brief parse next attribute of current start tag into tok->attr
+ *
+ * @return false if there is no more attribute (or it is malformed, then
+ *         xml__tok_next() reports the error)
+ */
+XML_INLINE
+bool
+xml__tok_attr(xml__tok_t * __restrict tok) {
+  char *p, *pend, c;
+
+  if (!tok->intag)
+    return false;
+
+  pend = (char *)tok->pend;
+  if ((p = (char *)xml__skip_space(tok->p, pend)) >= pend)
+    return false;
+
+  tok->p = p;
+  if ((c = *p) == '>' || c == '/')
+    return false;
+
+  if (!(p = xml__parse_attr(&tok->idx, &tok->attr, p, pend, true, &c)))
+    return false;
+
+  tok->p     = p;
+  tok->depth = tok->level - 1;
+  return true;
+}
+
+/*!
+ * @brief next token
+ *
+ * START is followed by its ATTR tokens, then END if tag is self closing.
+ * For END of self closing tag, tag and prefix are same as START.
+ */
+XML_STATIC
+xml__tok_kind_t
+xml__tok_next(xml__tok_t * __restrict tok) {
+  char *p, *q, *pend;
+
+  /* attributes */
+  if (tok->intag && xml__tok_attr(tok))
+    return XML__TOK_ATTR;
+
+  p    = (char *)tok->p;
+  pend = (char *)tok->pend;
+
+  if (tok->intag) {
+    if (p >= pend)
+      goto err;
+
+    if (*p == '/') {
+      p = (char *)xml__skip_space(p + 1, pend);
+      if (p >= pend || *p != '>')
+        goto err;
+
+      tok->intag = false;
+      tok->p     = p + 1;
+      tok->depth = --tok->level;
+      return XML__TOK_END;
+    }
+
+    if (*p != '>')
+      goto err;
+
+    tok->intag = false;
+    p++;
+  }
+
+  for (;;) {
+    tok->entity = false;
+    q           = (char *)xml__index_find_amp(&tok->idx, p, '<', &tok->entity);
+
+    if (q >= pend) {
+      if (tok->level > 0)
+        goto err;
+
+      tok->p = pend;
+      return XML__TOK_EOF;
+    }
+
+    if (q > p && tok->level > 0 && xml__skip_space(p, q) < q) {
+      tok->val     = p;
+      tok->valsize = (uint32_t)(q - p);
+      tok->depth   = tok->level;
+      tok->p       = q;
+      return XML__TOK_TEXT;
+    }
+
+    if ((p = q + 1) >= pend)
+      goto err;
+
+    switch (*p) {
+      case '/': /* end tag */
+        if (tok->level == 0)
+          goto err;
+
+        tok->prefix     = NULL;
+        tok->prefixsize = 0;
+        tok->tag        = ++p;
+
+        if ((p = (char *)xml__scan_name_end(p, pend)) >= pend)
+          goto err;
+
+        if (tok->sepPrefixes)
+          xml__split_prefix(&tok->tag, &tok->prefix, &tok->prefixsize, p);
+
+        tok->tagsize = (uint32_t)(p - tok->tag);
+
+        p = (char *)xml__skip_space(p, pend);
+        if (p >= pend || *p != '>')
+          goto err;
+
+        tok->p     = p + 1;
+        tok->depth = --tok->level;
+        return XML__TOK_END;
+      case '!':
+        /* CDATA is character data like text, it is kept as a token */
+        if (tok->level > 0 && xml__section(p, pend) == XML_CDATA) {
+          if (!(q = xml__section_end(p + 8, pend, ']')))
+            goto err;
+
+          tok->val     = p + 8;
+          tok->valsize = (uint32_t)(q - 2 - tok->val);
+          tok->depth   = tok->level;
+          tok->p       = q + 1;
+          return XML__TOK_CDATA;
+        }
+        /* fall through */
+      case '?':
+        if (!(q = xml__skip_markup(&tok->idx, p, pend)))
+          goto err;
+
+        p = q + 1;
+        continue;
+      default:
+        break;
+    }
+
+    /* start tag */
+    tok->prefix     = NULL;
+    tok->prefixsize = 0;
+    tok->tag        = p;
+
+    if ((p = (char *)xml__scan_name_end(p, pend)) >= pend)
+      goto err;
+
+    if (tok->sepPrefixes)
+      xml__split_prefix(&tok->tag, &tok->prefix, &tok->prefixsize, p);
+
+    tok->tagsize = (uint32_t)(p - tok->tag);
+    tok->intag   = true;
+    tok->p       = p;
+    tok->depth   = tok->level++;
+    return XML__TOK_START;
+  }
+
+err:
+  tok->p = pend;
+  return XML__TOK_ERROR;
+}
+
+#endif /* xml_impl_token_h */
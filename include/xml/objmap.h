@@ -74,6 +74,79 @@ xml_objmap_call(xml_t        * __restrict obj,
                 size_t                    count,
                 bool         * __restrict stop);
 
+/*
+ * compiled objmap: keys of an objmap are hashed once into a collision-free
+ * (perfect) table, then each child is matched with one hash and one compare
+ * instead of comparing it with all keys. It can be reused for many objects
+ * and documents:
+ *
+ *   cmap = xml_cobjmap_new(objmap, XML_ARR_LEN(objmap));
+ *   for (...) {
+ *     doc = xml_parse(...);
+ *     xml_cobjmap_call(doc->root, cmap, NULL);
+ *     ...
+ *   }
+ *   xml_cobjmap_free(cmap);
+ *
+ * Same key may be used by multiple entries, children which have that tag are
+ * collected in order: first child to first entry, second child to second
+ * entry... Other children are ignored. If key is used once then first child
+ * which has that tag is found, like xml_elem().
+ */
+typedef struct xml_cobjmap_slot_t {
+  uint32_t first; /* index + 1 of first entry of key, 0 for empty slot */
+  uint32_t last;  /* index of last entry of key                        */
+} xml_cobjmap_slot_t;
+
+typedef struct xml_cobjmap_t {
+  xml_objmap_t       *objmap; /* results are stored to objects of entries */
+  size_t              count;
+  uint32_t           *next;   /* index + 1 of next entry of same key or 0 */
+  xml_cobjmap_slot_t *slots;
+  uint64_t            seed;   /* seed which makes table collision-free    */
+  uint32_t            mask;   /* capacity of slots - 1                    */
+} xml_cobjmap_t;
+
+/*!
+ * @brief compile objmap, objmap is not copied and must be alive while
+ *        compiled map is used
+ *
+ * keysize of entries is set if it is 0.
+ *
+ * @param[in] objmap objmap array
+ * @param[in] count  number of entries
+ * @return compiled map or NULL, free it with xml_cobjmap_free()
+ */
+XML_INLINE
+xml_cobjmap_t*
+xml_cobjmap_new(xml_objmap_t * __restrict objmap, size_t count);
+
+XML_INLINE
+void
+xml_cobjmap_free(xml_cobjmap_t * __restrict cmap);
+
+/*!
+ * @brief map children of obj to entries, see xml_objmap()
+ *
+ * objects of entries are reset first, so same map can be used again.
+ *
+ * @param[in] obj  xml element
+ * @param[in] cmap compiled map
+ */
+XML_INLINE
+void
+xml_cobjmap(xml_t * __restrict obj, xml_cobjmap_t * __restrict cmap);
+
+/*!
+ * @brief map children of obj and call functions of entries in map order,
+ *        see xml_objmap_call()
+ */
+XML_INLINE
+void
+xml_cobjmap_call(xml_t         * __restrict obj,
+                 xml_cobjmap_t * __restrict cmap,
+                 bool          * __restrict stop);
+
 #include "impl/impl_objmap.h"
 
 #endif /* xml_objmap_h */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Multi-threaded parsing of one large document whose root has many children
+ * e.g. exports with millions of <record> elements.
+ *
+ * Root's content is split into pieces at sibling boundaries, pieces are
+ * parsed concurrently, each into its own memory, then subtrees are linked
+ * under root in document order. Result is same as xml_parse_n().
+ *
+ * Link with pthreads on POSIX systems (-pthread).
+ */
+
+#ifndef xml_parallel_h
+#define xml_parallel_h
+
+#include "common.h"
+#include "xml.h"
+
+/* documents smaller than this (per thread) are not split */
+#ifndef XML_PARALLEL_MIN
+#  define XML_PARALLEL_MIN (1024 * 1024)
+#endif
+
+/* max number of pieces (threads) */
+#ifndef XML_PARALLEL_MAX
+#  define XML_PARALLEL_MAX 256
+#endif
+
+/*!
+ * @brief parse xml string by using multiple threads
+ *
+ * Pieces are found by searching start tag of root's last child (e.g. <record)
+ * near to equal sized split points. Pieces are verified before linking, if a
+ * split point is not a sibling boundary (e.g. same tag is nested) or document
+ * has no such structure, it falls back to single-threaded xml_parse_n().
+ *
+ * @param[in] contents XML string, doesn't need to be null terminated
+ * @param[in] len      length of contents in bytes
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @param[in] nthreads number of threads (including caller), 0 for all CPUs
+ * @return xml document which contains xml object as root object
+ */
+XML_INLINE
+xml_doc_t*
+xml_parse_parallel(const char * __restrict contents,
+                   size_t                   len,
+                   xml_options_t            options,
+                   uint32_t                 nthreads);
+
+#include "impl/impl_parallel.h"
+
+#endif /* xml_parallel_h */
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Document pool: released documents are kept with their memory pages and
+ * they are reused by next parses, so parsing many small documents doesn't
+ * allocate memory after pool is warmed up.
+ *
+ * Pool has no locks, use one pool per thread e.g. as a thread local variable.
+ * A document must be released to the pool which it is taken from.
+ *
+ * Usage:
+ *
+ *   xml_pool_t pool;
+ *
+ *   xml_pool_init(&pool, 16 * 1024 * 1024, NULL);
+ *
+ *   while (...) {
+ *     doc = xml_pool_parse(&pool, contents, len, XML_DEFAULTS);
+ *     ...
+ *     xml_pool_release(&pool, doc);
+ *   }
+ *
+ *   xml_pool_destroy(&pool);
+ */
+
+#ifndef xml_pool_h
+#define xml_pool_h
+
+#include "common.h"
+#include "xml.h"
+
+typedef struct xml_pool_stats_t {
+  size_t hits;     /* parses which reused a released document           */
+  size_t misses;   /* parses which created new document                 */
+  size_t dropped;  /* released documents which are freed because of cap */
+  size_t retained; /* bytes which are kept by pool (documents and pages) */
+  size_t count;    /* number of documents in pool                       */
+} xml_pool_stats_t;
+
+typedef struct xml_pool_t {
+  xml_doc_t        *free;      /* released documents              */
+  xml_allocator_t   allocator;
+  bool              hasalloc;  /* allocator is used for new documents */
+  size_t            maxmem;    /* cap of retained memory in bytes */
+  xml_pool_stats_t  stats;
+
+  /* registered names for XML_ATOMS, see doc->atombase and xml/atom.h */
+  const struct xml_atoms_t *atombase;
+} xml_pool_t;
+
+/*!
+ * @brief initialize a pool, pool itself is not allocated
+ *
+ * @param[out] pool      pool
+ * @param[in]  maxmem    max bytes which are kept by pool, 0 for no limit
+ * @param[in]  allocator allocator of new documents or NULL for malloc / free
+ */
+XML_INLINE
+void
+xml_pool_init(xml_pool_t            * __restrict pool,
+              size_t                             maxmem,
+              const xml_allocator_t * __restrict allocator);
+
+/*!
+ * @brief parse xml string into a document from pool, see xml_parse_doc()
+ *
+ * @param[in] pool     pool
+ * @param[in] contents XML string (may not be NULL terminated)
+ * @param[in] len      byte length of contents
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return document, give it back with xml_pool_release()
+ */
+XML_INLINE
+xml_doc_t*
+xml_pool_parse(xml_pool_t * __restrict pool,
+               const char * __restrict contents,
+               size_t                  len,
+               xml_options_t           options);
+
+/*!
+ * @brief give document back to pool
+ *
+ * document is reset and kept for next parses. If retained memory would
+ * exceed the cap then its spare pages are freed first, if it still doesn't
+ * fit then document is freed.
+ *
+ * @param[in] pool pool
+ * @param[in] doc  document which is returned by xml_pool_parse()
+ */
+XML_INLINE
+void
+xml_pool_release(xml_pool_t * __restrict pool, xml_doc_t * __restrict doc);
+
+/*!
+ * @brief free all documents which are kept by pool
+ *
+ * documents which are not released yet are not freed, pool can be used again
+ * after this.
+ *
+ * @param[in] pool pool
+ */
+XML_INLINE
+void
+xml_pool_destroy(xml_pool_t * __restrict pool);
+
+#include "impl/impl_pool.h"
+
+#endif /* xml_pool_h */
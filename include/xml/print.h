@@ -100,7 +100,17 @@ xml_print_ex(FILE  * __restrict ostream,
         break;
       }
       case XML_STRING:
-        fprintf(ostream, "%.*s", xml->valsize, xml->val);
+        fprintf(ostream, "%.*s", xml->valsize, (const char *)xml->val);
+        snode = 1;
+        break;
+      case XML_CDATA:
+        fprintf(ostream, "<![CDATA[%.*s]]>",
+                xml->valsize, (const char *)xml->val);
+        snode = 1;
+        break;
+      case XML_COMMENT:
+        fprintf(ostream, "<!--%.*s-->",
+                xml->valsize, (const char *)xml->val);
         snode = 1;
         break;
       default:
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Push (incremental) parser: feed the document in chunks as they arrive
+ * e.g. from network, tree is built into a single xml_doc_t while feeding.
+ *
+ * Usage:
+ *
+ *   xml_parser_t *parser;
+ *   xml_doc_t    *doc;
+ *
+ *   parser = xml_parser_new(XML_DEFAULTS);
+ *
+ *   while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+ *     if (!xml_parser_feed(parser, buf, n))
+ *       break;
+ *   }
+ *
+ *   doc = xml_parser_finish(parser);
+ *   ...
+ *   xml_free(doc);
+ *
+ * Chunks can be split at any byte. Complete markups are copied into the
+ * document's memory and parsed immediately, only the incomplete tail
+ * (trailing text and partial markup) is kept by parser until next chunk.
+ * So the caller's buffer can be reused after xml_parser_feed() returns.
+ */
+
+#ifndef xml_push_h
+#define xml_push_h
+
+#include "common.h"
+#include "xml.h"
+
+typedef struct xml_parser_t xml_parser_t;
+
+/*!
+ * @brief create a push parser
+ *
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return parser, free it with xml_parser_finish() or xml_parser_free()
+ */
+XML_INLINE
+xml_parser_t*
+xml_parser_new(xml_options_t options);
+
+/*!
+ * @brief parse next chunk of the document
+ *
+ * @param[in] parser parser
+ * @param[in] buf    chunk, doesn't need to be null terminated
+ * @param[in] len    chunk length in bytes
+ * @return false if document is malformed, next calls will fail too
+ */
+XML_INLINE
+bool
+xml_parser_feed(xml_parser_t * __restrict parser,
+                const char   * __restrict buf,
+                size_t                    len);
+
+/*!
+ * @brief finish parsing, parse remaining bytes and free the parser
+ *
+ * document is returned even if document is malformed or incomplete like
+ * xml_parse() does, it contains the tree which is parsed until the error.
+ *
+ * @param[in] parser parser, it is freed by this function
+ * @return xml document, free it with xml_free()
+ */
+XML_INLINE
+xml_doc_t*
+xml_parser_finish(xml_parser_t * __restrict parser);
+
+/*!
+ * @brief abort parsing, free the parser and the document which is built so far
+ *
+ * @param[in] parser parser
+ */
+XML_INLINE
+void
+xml_parser_free(xml_parser_t * __restrict parser);
+
+#include "impl/impl_push.h"
+
+#endif /* xml_push_h */
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Path queries: a small XPath subset which is compiled once and run many
+ * times, over xml_t trees or over contents with tokenizer (without DOM).
+ * Running a query never allocates memory, iterators have fixed size and they
+ * can live in stack.
+ *
+ * Supported syntax:
+ *
+ *   /a/b        child steps from root element (absolute)
+ *   a/b         child steps from context element (relative)
+ *   //b, a//b   descendant steps
+ *   *, p:a      any element, prefixed name (with XML_PREFIXES, prefix of
+ *               element is ignored if it is not given in query)
+ *   a/@id, a/@* attribute of matched elements, only as last step
+ *   //@id       attributes of all elements
+ *   [2]         position among siblings which pass name test and preceding
+ *               predicates (1 based, in list order)
+ *   [@id]       attribute exists
+ *   [@id='x']   attribute value is equal (or != not equal) to literal
+ *   [b]         child element exists               (DOM only)
+ *   [b='x']     first text of a child element is literal (DOM only)
+ *
+ * Values are compared as they are in contents, entity references are not
+ * decoded. Example:
+ *
+ *   query = xml_query_compile("/feed/entry[@type='x']/link/@href");
+ *
+ *   xml_query_begin(&it, query, doc->root);
+ *   while (xml_query_next(&it)) {
+ *     ... it.attr->val, it.attr->valsize
+ *   }
+ *
+ *   xml_query_free(query);
+ */
+
+#ifndef xml_query_h
+#define xml_query_h
+
+#include "common.h"
+#include "xml.h"
+
+/* max number of element steps, states of steps are stored as bits */
+#ifndef XML_QUERY_MAX_STEPS
+#  define XML_QUERY_MAX_STEPS 16
+#endif
+
+/* max number of predicates in a query */
+#ifndef XML_QUERY_MAX_PREDS
+#  define XML_QUERY_MAX_PREDS 32
+#endif
+
+/* max depth which is tracked by iterators, deeper elements are not visited */
+#ifndef XML_QUERY_MAX_DEPTH
+#  define XML_QUERY_MAX_DEPTH 64
+#endif
+
+typedef enum xml_query_pred_kind_t {
+  XML_QUERY_PRED_POS      = 0, /* [2]                                      */
+  XML_QUERY_PRED_ATTR     = 1, /* [@a]                                     */
+  XML_QUERY_PRED_ATTR_EQ  = 2, /* [@a='x']                                 */
+  XML_QUERY_PRED_ATTR_NE  = 3, /* [@a!='x'], false without attribute       */
+  XML_QUERY_PRED_CHILD    = 4, /* [b]                                      */
+  XML_QUERY_PRED_CHILD_EQ = 5  /* [b='x']                                  */
+} xml_query_pred_kind_t;
+
+typedef struct xml_query_pred_t {
+  const char            *name;
+  const char            *val;
+  uint32_t               namesize;
+  uint32_t               valsize;
+  uint32_t               pos;
+  xml_query_pred_kind_t  kind;
+} xml_query_pred_t;
+
+typedef struct xml_query_step_t {
+  const char *name;       /* name without prefix, NULL for '*'          */
+  const char *prefix;     /* prefix, NULL if it is not given            */
+  uint32_t    namesize;
+  uint32_t    prefixsize;
+  uint32_t    pred;       /* predicates are preds[pred, pred + npred)   */
+  uint32_t    npred;
+  bool        descendant; /* step follows '//'                          */
+} xml_query_step_t;
+
+typedef struct xml_query_t {
+  xml_query_step_t steps[XML_QUERY_MAX_STEPS];
+  xml_query_pred_t preds[XML_QUERY_MAX_PREDS];
+  xml_query_step_t attr;       /* last step if hasattr, name has prefix */
+  uint32_t         nsteps;     /* number of element steps               */
+  uint32_t         npreds;
+  bool             absolute;
+  bool             hasattr;
+  bool             haspos;
+  bool             streamable; /* no child predicates, see stream       */
+  char             expr[];     /* copy of expression, names point here  */
+} xml_query_t;
+
+/* DOM iterator, see xml_query_begin() */
+typedef struct xml_query_iter_t {
+  const xml_query_t *query;
+  xml_t             *node;      /* matched element or owner of attribute */
+  xml_attr_t        *attr;      /* matched attribute for attribute query */
+  xml_attr_t        *nextattr;
+  uint32_t           level;     /* level of node, context's children: 1  */
+  uint32_t           state;
+  bool               truncated; /* elements deeper than max are skipped  */
+  uint32_t           mask[XML_QUERY_MAX_DEPTH + 1];
+  uint32_t           pos[XML_QUERY_MAX_DEPTH + 1][XML_QUERY_MAX_STEPS];
+} xml_query_iter_t;
+
+typedef enum xml_query_match_t {
+  XML_QUERY_EOF   = 0, /* end of contents                          */
+  XML_QUERY_ERROR = 1, /* malformed contents or too deep document  */
+  XML_QUERY_ELEM  = 2, /* element is matched, see tag and prefix   */
+  XML_QUERY_ATTR  = 3  /* attribute is matched, see attr           */
+} xml_query_match_t;
+
+/* streaming matcher, see xml_query_stream_init() */
+typedef struct xml_query_stream_t {
+  const xml_query_t *query;
+  const char        *prefix;     /* matched element or owner of attribute */
+  const char        *tag;
+  xml_attr_t         attr;       /* XML_QUERY_ATTR, attr.next is NULL     */
+  uint32_t           prefixsize;
+  uint32_t           tagsize;
+  uint32_t           depth;      /* depth of element, root is 0          */
+  const char        *attrp;      /* private                              */
+  bool               skip;       /* private                              */
+  uint32_t           mask[XML_QUERY_MAX_DEPTH + 1];
+  uint32_t           pos[XML_QUERY_MAX_DEPTH + 1][XML_QUERY_MAX_STEPS];
+  xml__tok_t         tok;        /* private                              */
+} xml_query_stream_t;
+
+/*!
+ * @brief compile query expression
+ *
+ * @param[in] expr null terminated expression, it is copied
+ * @return compiled query or NULL if expression is not supported or invalid,
+ *         free it with xml_query_free()
+ */
+XML_INLINE
+xml_query_t*
+xml_query_compile(const char * __restrict expr);
+
+XML_INLINE
+void
+xml_query_free(xml_query_t * __restrict query);
+
+/*!
+ * @brief start to iterate matches of query
+ *
+ * relative queries start from children of context, absolute queries start
+ * from root element of context's tree.
+ *
+ * @param[out] it    iterator
+ * @param[in]  query compiled query
+ * @param[in]  ctx   context element
+ */
+XML_INLINE
+void
+xml_query_begin(xml_query_iter_t  * __restrict it,
+                const xml_query_t * __restrict query,
+                xml_t             * __restrict ctx);
+
+/*!
+ * @brief next match in document order
+ *
+ * @param[in] it iterator
+ * @return matched element (owner element for attribute queries, matched
+ *         attribute is it->attr) or NULL if there is no more match
+ */
+XML_INLINE
+xml_t*
+xml_query_next(xml_query_iter_t * __restrict it);
+
+/*!
+ * @brief first matched element
+ */
+XML_INLINE
+xml_t*
+xml_query_first(const xml_query_t * __restrict query, xml_t * __restrict ctx);
+
+/*!
+ * @brief first matched attribute of attribute query
+ */
+XML_INLINE
+xml_attr_t*
+xml_query_first_attr(const xml_query_t * __restrict query,
+                     xml_t             * __restrict ctx);
+
+/*!
+ * @brief match query while tokenizing contents, without building DOM
+ *
+ * query is run from document (relative queries too). Subtrees which can't
+ * match are skipped. Only XML_PREFIXES option is used.
+ *
+ * @param[out] stream   stream
+ * @param[in]  query    compiled query
+ * @param[in]  contents XML string, doesn't need to be null terminated
+ * @param[in]  len      length of contents in bytes
+ * @param[in]  options  options use XML_DEFAULTS or XML_NONE for default
+ * @return false if query has predicates which need DOM e.g. [b]
+ */
+XML_INLINE
+bool
+xml_query_stream_init(xml_query_stream_t * __restrict stream,
+                      const xml_query_t  * __restrict query,
+                      const char         * __restrict contents,
+                      size_t                          len,
+                      xml_options_t                   options);
+
+/*!
+ * @brief next match in document order
+ *
+ * @param[in] stream stream
+ * @return XML_QUERY_ELEM, XML_QUERY_ATTR, XML_QUERY_EOF at the end or
+ *         XML_QUERY_ERROR
+ */
+XML_INLINE
+xml_query_match_t
+xml_query_stream_next(xml_query_stream_t * __restrict stream);
+
+#include "impl/impl_query.h"
+
+#endif /* xml_query_h */
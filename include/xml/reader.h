@@ -0,0 +1,106 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Pull reader (cursor): caller drives tokenizer from its own loop, it can stop
+ * at any time. Reader has a fixed size and it can live in stack, it never
+ * allocates memory and never modifies contents. Strings are spans in
+ * contents (they are not null terminated).
+ *
+ * Example:
+ *
+ *   xml_reader_t reader;
+ *   xml_token_t  t;
+ *
+ *   xml_reader_init(&reader, contents, len, XML_DEFAULTS);
+ *
+ *   while ((t = xml_reader_next(&reader)) > XML_TOKEN_ERROR) {
+ *     switch (t) {
+ *       case XML_TOKEN_START: ... reader.tag, reader.tagsize
+ *       case XML_TOKEN_ATTR:  ... reader.attr
+ *       case XML_TOKEN_TEXT:  ... reader.val, reader.valsize
+ *       case XML_TOKEN_CDATA: ... reader.val, reader.valsize
+ *       case XML_TOKEN_END:   ...
+ *     }
+ *   }
+ *
+ *   if (t == XML_TOKEN_ERROR) ... malformed
+ */
+
+#ifndef xml_reader_h
+#define xml_reader_h
+
+#include "common.h"
+#include "xml.h"
+
+/* values are same as tokenizer's, see impl_token.h */
+typedef enum xml_token_t {
+  XML_TOKEN_EOF   = XML__TOK_EOF,   /* end of contents                      */
+  XML_TOKEN_ERROR = XML__TOK_ERROR, /* malformed contents                   */
+  XML_TOKEN_START = XML__TOK_START, /* start tag, followed by its ATTRs      */
+  XML_TOKEN_ATTR  = XML__TOK_ATTR,  /* attribute of last start tag           */
+  XML_TOKEN_TEXT  = XML__TOK_TEXT,  /* text, whitespace-only runs skipped    */
+  XML_TOKEN_END   = XML__TOK_END,   /* end tag, also for self closing tag    */
+  XML_TOKEN_CDATA = XML__TOK_CDATA  /* payload of CDATA section, not decoded */
+} xml_token_t;
+
+typedef struct xml_reader_t {
+  xml_token_t  token;      /* last token                                */
+  const char  *prefix;     /* START / END, NULL if there is no prefix   */
+  const char  *tag;        /* START / END                               */
+  const char  *val;        /* TEXT, CDATA                               */
+  xml_attr_t   attr;       /* ATTR, attr.next is always NULL            */
+  uint32_t     prefixsize;
+  uint32_t     tagsize;
+  uint32_t     valsize;
+  uint32_t     depth;      /* root element is 0, ATTR has element depth */
+  xml__tok_t   tok;        /* private                                   */
+} xml_reader_t;
+
+/*!
+ * @brief initialize reader, only XML_PREFIXES option is used
+ *
+ * @param[out] reader   reader
+ * @param[in]  contents XML string, doesn't need to be null terminated
+ * @param[in]  len      length of contents in bytes
+ * @param[in]  options  options use XML_DEFAULTS or XML_NONE for default
+ */
+XML_INLINE
+void
+xml_reader_init(xml_reader_t * __restrict reader,
+                const char   * __restrict contents,
+                size_t                    len,
+                xml_options_t             options);
+
+/*!
+ * @brief read next token
+ *
+ * end tag names are not matched with start tag names, only depth is tracked.
+ *
+ * @param[in] reader reader
+ * @return token, XML_TOKEN_EOF or XML_TOKEN_ERROR at the end
+ */
+XML_INLINE
+xml_token_t
+xml_reader_next(xml_reader_t * __restrict reader);
+
+/*!
+ * @brief skip rest of current element (attributes and children)
+ *
+ * if current token is START or ATTR, reader is moved to END of that element,
+ * otherwise nothing is done.
+ *
+ * @param[in] reader reader
+ * @return current token: XML_TOKEN_END or XML_TOKEN_ERROR
+ */
+XML_INLINE
+xml_token_t
+xml_reader_skip_subtree(xml_reader_t * __restrict reader);
+
+#include "impl/impl_reader.h"
+
+#endif /* xml_reader_h */
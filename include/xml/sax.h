@@ -0,0 +1,100 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * SAX-style (callback) parsing: events are reported directly from tokenizer,
+ * no tree is built and no memory is allocated. Contents are not modified,
+ * strings are spans in contents (they are not null terminated). Payload of
+ * CDATA sections is reported as text, it is not decoded.
+ *
+ * Example:
+ *
+ *   bool
+ *   on_start(void * __restrict userdata, xml_sax_elem_t * __restrict elem) {
+ *     xml_attr_t attr;
+ *
+ *     while (xml_sax_attr_next(elem, &attr)) {
+ *       ...
+ *     }
+ *
+ *     return true; // return false to stop parsing
+ *   }
+ *
+ *   xml_sax_t sax = { .start = on_start };
+ *   xml_sax_parse(contents, len, XML_DEFAULTS, &sax);
+ */
+
+#ifndef xml_sax_h
+#define xml_sax_h
+
+#include "common.h"
+#include "xml.h"
+
+struct xml__tok_t;
+
+typedef struct xml_sax_elem_t {
+  const char        *prefix;     /* NULL if there is no prefix           */
+  const char        *tag;
+  uint32_t           prefixsize;
+  uint32_t           tagsize;
+  uint32_t           depth;      /* root element is 0                    */
+  struct xml__tok_t *tok;        /* private, used by xml_sax_attr_next() */
+} xml_sax_elem_t;
+
+/* callbacks return false to stop parsing */
+typedef bool (*xml_sax_start_t)(void           * __restrict userdata,
+                                xml_sax_elem_t * __restrict elem);
+typedef bool (*xml_sax_text_t)(void       * __restrict userdata,
+                               const char * __restrict text,
+                               size_t                  len);
+typedef bool (*xml_sax_end_t)(void                 * __restrict userdata,
+                              const xml_sax_elem_t * __restrict elem);
+
+typedef struct xml_sax_t {
+  xml_sax_start_t start; /* start tag, optional                       */
+  xml_sax_text_t  text;  /* text, whitespace-only runs are not reported */
+  xml_sax_end_t   end;   /* end tag, also reported for self closing tag */
+  void           *userdata;
+} xml_sax_t;
+
+/*!
+ * @brief parse XML and report events to callbacks, no tree is built
+ *
+ * only XML_PREFIXES option is used, contents are never modified.
+ * end tag names are not matched with start tag names.
+ *
+ * @param[in] contents XML string, doesn't need to be null terminated
+ * @param[in] len      length of contents in bytes
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @param[in] sax      callbacks
+ * @return false if document is malformed, stopping by callback is not error
+ */
+XML_INLINE
+bool
+xml_sax_parse(const char      * __restrict contents,
+              size_t                       len,
+              xml_options_t                options,
+              const xml_sax_t * __restrict sax);
+
+/*!
+ * @brief read next attribute of element, only valid in start callback
+ *
+ * attributes are parsed on demand, attributes which are not read are skipped.
+ * attr->next is always NULL.
+ *
+ * @param[in]  elem element which is passed to start callback
+ * @param[out] attr attribute
+ * @return false if there is no more attribute
+ */
+XML_INLINE
+bool
+xml_sax_attr_next(xml_sax_elem_t * __restrict elem,
+                  xml_attr_t     * __restrict attr);
+
+#include "impl/impl_sax.h"
+
+#endif /* xml_sax_h */
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Serializer: writes xml_t trees into a writer instead of printing each
+ * token with fprintf like xml_print_ex(). Writer batches output in a buffer,
+ * sinks are:
+ *
+ *   - memory: growable buffer (or caller's fixed buffer), output is
+ *             writer.buf, writer.len
+ *   - fd:     file descriptor, buffer and long values (which are referenced,
+ *             not copied) are written with writev()
+ *   - write:  callback, it is called with full buffers
+ *
+ * Parsed strings are raw (already escaped) and they are written as they are
+ * like xml_print_ex(). Text and attribute values which are flagged with
+ * `decoded` (set by xml_val_decode(), xmla_decode()) are plain text, they are
+ * escaped: '&', '<', '>' in text and '&', '<', quote of attribute
+ * (xml_attr_t.valquote or '"') in attribute values. XML_SERIALIZE_ESCAPE
+ * escapes all values e.g. after xml_doc_decode() or for values set by hand.
+ * Escaping scans values in vector-sized strides, runs without special
+ * characters are copied as they are.
+ *
+ * xml_serialize_len() computes exact size of output, so output can be
+ * written into a pre-sized buffer in one pass:
+ *
+ *   len = xml_serialize_len(doc->root, XML_SERIALIZE_DEFAULT);
+ *   buf = malloc(len);
+ *
+ *   xml_writer_mem(&w, buf, len);
+ *   xml_serialize(&w, doc->root, XML_SERIALIZE_DEFAULT);
+ *
+ * or xml_serialize_str() does same. POSIX and Windows are supported for fd
+ * sink, on POSIX systems compile with _POSIX_C_SOURCE >= 200112L or
+ * _DEFAULT_SOURCE if you are using a strict C standard mode e.g. -std=c99.
+ *
+ * With XML_SERIALIZE_SPANS, elements which are not changed after parse are
+ * copied from contents as they are (one copy per subtree, or one iovec for
+ * fd sink) instead of walking their nodes. Document must be parsed with
+ * XML_READONLY (without XML_REVERSE) and changed nodes must be marked with
+ * xml_touch(). Only elements which source has nothing but their nodes are
+ * copied (see xml_src()): subtrees with skipped comments, processing
+ * instructions or whitespace-only text are walked, so output is same
+ * document as the walk writes, only formatting inside tags e.g. quotes or
+ * <a></a> is kept as in input. It is ignored with XML_SERIALIZE_PRETTY:
+ *
+ *   doc  = xml_parse_n(contents, len, XML_READONLY);
+ *   attr = xmla(item, "status");
+ *
+ *   attr->val     = "done";
+ *   attr->valsize = 4;
+ *   xml_touch(item);
+ *
+ *   xml_serialize(&w, doc->root, XML_SERIALIZE_SPANS);
+ *
+ * only path from root to item is serialized node by node.
+ */
+
+#ifndef xml_serialize_h
+#define xml_serialize_h
+
+#include "common.h"
+#include "xml.h"
+
+/* size of buffer of fd and callback sinks */
+#ifndef XML_WRITER_BUFSIZE
+#  define XML_WRITER_BUFSIZE (64 * 1024)
+#endif
+
+/* fd sink: values which are longer than this are not copied into buffer */
+#ifndef XML_WRITER_SPAN_MIN
+#  define XML_WRITER_SPAN_MIN 512
+#endif
+
+/* fd sink: max number of buffers in one writev() */
+#ifndef XML_WRITER_IOV
+#  define XML_WRITER_IOV 64
+#endif
+
+typedef enum xml_serialize_flags_t {
+  XML_SERIALIZE_DEFAULT = 0,
+  XML_SERIALIZE_PRETTY  = 1, /* indent with tabs, elements which have text
+                                children are not indented inside          */
+  XML_SERIALIZE_SPANS   = 2, /* copy unchanged exact elements from input  */
+  XML_SERIALIZE_ESCAPE  = 4  /* all values are plain text, escape them    */
+} xml_serialize_flags_t;
+
+typedef enum xml_sink_t {
+  XML_SINK_MEM   = 0,
+  XML_SINK_FIXED = 1, /* caller's buffer, it is not grown */
+  XML_SINK_FD    = 2,
+  XML_SINK_WRITE = 3
+} xml_sink_t;
+
+/*!
+ * @brief writer callback
+ *
+ * @param[in] ctx  writer.ctx
+ * @param[in] data bytes to write
+ * @param[in] len  number of bytes
+ * @return false on error, writer stops writing
+ */
+typedef bool (*xml_write_fn)(void       * __restrict ctx,
+                             const char * __restrict data,
+                             size_t                  len);
+
+typedef struct xml_writer_span_t {
+  const char *data;
+  size_t      len;
+} xml_writer_span_t;
+
+typedef struct xml_writer_t {
+  char             *buf;     /* output of memory sink, else buffer         */
+  size_t            len;     /* bytes in buf                               */
+  size_t            cap;     /* capacity of buf                            */
+  size_t            flushed; /* bytes written to sink or referenced (fd)   */
+  xml_write_fn      write;
+  void             *ctx;
+  int               fd;
+  xml_sink_t        sink;
+  bool              failed;  /* allocation or write error, output is cut   */
+  uint32_t          niov;    /* fd: spans waiting for writev()             */
+  size_t            seg;     /* fd: begin of buf which is not in iov yet   */
+  xml_writer_span_t iov[XML_WRITER_IOV];
+} xml_writer_t;
+
+/*!
+ * @brief init memory sink
+ *
+ * @param[out] w   writer
+ * @param[in]  buf caller's buffer or NULL to allocate a growable buffer,
+ *                 free it with xml_writer_free()
+ * @param[in]  cap capacity of buf, if buf is full writer fails
+ */
+XML_INLINE
+void
+xml_writer_mem(xml_writer_t * __restrict w, char * __restrict buf, size_t cap);
+
+/*!
+ * @brief init file descriptor sink
+ *
+ * @return false if buffer couldn't be allocated
+ */
+XML_INLINE
+bool
+xml_writer_fd(xml_writer_t * __restrict w, int fd);
+
+/*!
+ * @brief init callback sink
+ *
+ * @return false if buffer couldn't be allocated
+ */
+XML_INLINE
+bool
+xml_writer_callback(xml_writer_t * __restrict w,
+                    xml_write_fn              write,
+                    void         * __restrict ctx);
+
+/*!
+ * @brief write bytes as they are e.g. XML declaration
+ *
+ * for fd sink data must be alive until next flush
+ *
+ * @return false if writer is failed
+ */
+XML_INLINE
+bool
+xml_write(xml_writer_t * __restrict w,
+          const char   * __restrict data,
+          size_t                    len);
+
+/*!
+ * @brief write buffered output to fd / callback, no-op for memory sinks
+ */
+XML_INLINE
+bool
+xml_writer_flush(xml_writer_t * __restrict w);
+
+/*!
+ * @brief total number of bytes which are written (flushed or buffered)
+ */
+XML_INLINE
+size_t
+xml_writer_total(const xml_writer_t * __restrict w);
+
+/*!
+ * @brief frees buffer which is allocated by writer, it doesn't flush
+ */
+XML_INLINE
+void
+xml_writer_free(xml_writer_t * __restrict w);
+
+/*!
+ * @brief write object and its subtree, siblings of object are not written
+ *
+ * fd and callback sinks are flushed at the end.
+ *
+ * @param[in] w      writer
+ * @param[in] object element or string, CDATA, comment node
+ * @param[in] flags  XML_SERIALIZE_DEFAULT or XML_SERIALIZE_* flags
+ * @return false if writer is failed
+ */
+XML_INLINE
+bool
+xml_serialize(xml_writer_t * __restrict w,
+              const xml_t  * __restrict object,
+              int                       flags);
+
+/*!
+ * @brief exact size of xml_serialize() output in bytes
+ */
+XML_INLINE
+size_t
+xml_serialize_len(const xml_t * __restrict object, int flags);
+
+/*!
+ * @brief serialize into a new null terminated string with exact size
+ *
+ * @param[in]  object object
+ * @param[in]  flags  flags
+ * @param[out] len    length without null terminator, can be NULL
+ * @return string (free it with free()) or NULL if allocation fails
+ */
+XML_INLINE
+char*
+xml_serialize_str(const xml_t * __restrict object,
+                  int                      flags,
+                  size_t      * __restrict len);
+
+#include "impl/impl_serialize.h"
+
+#endif /* xml_serialize_h */
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+/*
+ * Tape: flat representation of document as an array of fixed size nodes in
+ * document order (start tag, its attributes, children, end tag). Strings are
+ * stored as 32-bit offsets in contents, contents are never modified and must
+ * be alive while tape is used.
+ *
+ * Each element node stores distance to its END node, so skipping a subtree is
+ * a single jump and iterating whole document is a linear scan over one
+ * contiguous array. Last node of tape is always XML_TAPE_EOF.
+ *
+ * Example:
+ *
+ *   xml_tape_t            *tape;
+ *   const xml_tape_node_t *root, *item;
+ *
+ *   tape = xml_parse_tape(contents, len, XML_DEFAULTS);
+ *   root = xml_tape_root(tape);
+ *
+ *   item = xml_tape_elem(tape, root, "item");
+ *   while (item) {
+ *     ... xml_tape_attr(tape, item, "id")
+ *     item = xml_tape_elem_next(tape, item, "item");
+ *   }
+ *
+ *   xml_tape_free(tape);
+ */
+
+#ifndef xml_tape_h
+#define xml_tape_h
+
+#include "common.h"
+#include "xml.h"
+
+typedef enum xml_tape_type_t {
+  XML_TAPE_EOF     = 0, /* end of tape                                   */
+  XML_TAPE_ELEMENT = 1, /* start tag, followed by its ATTR nodes         */
+  XML_TAPE_ATTR    = 2, /* attribute of previous ELEMENT                 */
+  XML_TAPE_TEXT    = 3, /* text, whitespace-only runs are not stored     */
+  XML_TAPE_END     = 4  /* end of element, also for self closing tag     */
+} xml_tape_type_t;
+
+typedef struct xml_tape_node_t {
+  uint32_t off;   /* offset of tag, text or attribute name in contents    */
+  uint32_t size;  /* length of tag, text or attribute name               */
+
+  /*
+   * ELEMENT: distance to its END node (node + link)
+   * END:     distance back to its ELEMENT node (node - link)
+   * ATTR:    offset of value in contents
+   */
+  uint32_t link;
+  uint16_t extra; /* ELEMENT / END: prefix size, ATTR: value size         */
+  uint8_t  type;  /* xml_tape_type_t                                      */
+  uint8_t  flags; /* XML_TAPE_ENTITY                                      */
+} xml_tape_node_t;
+
+/* TEXT / ATTR: text or value contains '&', see xml_decode() */
+#define XML_TAPE_ENTITY 1
+
+/* TEXT: payload of CDATA section, it is not decoded */
+#define XML_TAPE_CDATA  2
+
+typedef struct xml_tape_t {
+  const char      *ptr;         /* contents, offsets are relative to this */
+  xml_tape_node_t *nodes;       /* count + 1 nodes, last is XML_TAPE_EOF  */
+  uint32_t         count;
+  bool             sepPrefixes;
+} xml_tape_t;
+
+/*!
+ * @brief parse xml string into tape
+ *
+ * only XML_PREFIXES option is used. If XML_PREFIXES is used then tag of
+ * element doesn't contain prefix, see xml_tape_prefix(). If document is
+ * malformed then tape contains nodes until the error and all open elements
+ * are closed.
+ *
+ * @param[in] contents XML string, doesn't need to be null terminated
+ * @param[in] len      length of contents in bytes, must be less than 4GB
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ * @return tape or NULL, free it with xml_tape_free()
+ */
+XML_INLINE
+xml_tape_t*
+xml_parse_tape(const char * __restrict contents,
+               size_t                   len,
+               xml_options_t            options);
+
+/*!
+ * @brief frees tape, contents are not freed
+ */
+XML_INLINE
+void
+xml_tape_free(xml_tape_t * __restrict tape);
+
+/*!
+ * @brief first top level element of tape (root element)
+ *
+ * @param[in] tape tape
+ * @return ELEMENT node or NULL
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_root(const xml_tape_t * __restrict tape);
+
+/*!
+ * @brief first child node (ELEMENT or TEXT) of element
+ *
+ * @param[in] node element node
+ * @return child node or NULL
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_first(const xml_tape_node_t * __restrict node);
+
+/*!
+ * @brief next sibling node (ELEMENT or TEXT), subtree of node is jumped over
+ *
+ * @param[in] node ELEMENT or TEXT node
+ * @return sibling node or NULL
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_next(const xml_tape_node_t * __restrict node);
+
+/*!
+ * @brief first node after subtree of node (after END of element)
+ *
+ * @param[in] node node
+ * @return node, it may be END of parent or XML_TAPE_EOF
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_skip(const xml_tape_node_t * __restrict node);
+
+/*!
+ * @brief tag of ELEMENT / END, text of TEXT or name of ATTR node
+ *
+ * string is not null terminated, length is node->size
+ */
+XML_INLINE
+const char*
+xml_tape_str(const xml_tape_t      * __restrict tape,
+             const xml_tape_node_t * __restrict node);
+
+/*!
+ * @brief prefix of ELEMENT / END node, length is node->extra
+ *
+ * @return prefix or NULL if there is no prefix
+ */
+XML_INLINE
+const char*
+xml_tape_prefix(const xml_tape_t      * __restrict tape,
+                const xml_tape_node_t * __restrict node);
+
+/*!
+ * @brief value of ATTR node, length is node->extra
+ */
+XML_INLINE
+const char*
+xml_tape_val(const xml_tape_t      * __restrict tape,
+             const xml_tape_node_t * __restrict node);
+
+/*!
+ * @brief get an attribute by name for given element, see xmla()
+ *
+ * @param[in] tape tape
+ * @param[in] node element node
+ * @param[in] name attribute name to find
+ * @return ATTR node or NULL
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_attr(const xml_tape_t      * __restrict tape,
+              const xml_tape_node_t * __restrict node,
+              const char            * __restrict name);
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_attr_sz(const xml_tape_t      * __restrict tape,
+                 const xml_tape_node_t * __restrict node,
+                 const char            * __restrict name,
+                 size_t                              namesize);
+
+/*!
+ * @brief get a child element by name for given element, see xml_elem()
+ *
+ * @param[in] tape tape
+ * @param[in] node element node
+ * @param[in] name element name to find
+ * @return ELEMENT node or NULL
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem(const xml_tape_t      * __restrict tape,
+              const xml_tape_node_t * __restrict node,
+              const char            * __restrict name);
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem_sz(const xml_tape_t      * __restrict tape,
+                 const xml_tape_node_t * __restrict node,
+                 const char            * __restrict name,
+                 size_t                              namesize);
+
+/*!
+ * @brief get next sibling element by name, see xml_elem_next()
+ *
+ * @param[in] tape    tape
+ * @param[in] current current node
+ * @param[in] name    element name to find
+ * @return ELEMENT node or NULL
+ */
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem_next(const xml_tape_t      * __restrict tape,
+                   const xml_tape_node_t * __restrict current,
+                   const char            * __restrict name);
+
+XML_INLINE
+const xml_tape_node_t*
+xml_tape_elem_next_sz(const xml_tape_t      * __restrict tape,
+                      const xml_tape_node_t * __restrict current,
+                      const char            * __restrict name,
+                      size_t                              namesize);
+
+#include "impl/impl_tape.h"
+
+#endif /* xml_tape_h */
@@ -27,6 +27,37 @@ typedef enum xml_options_t {
    */ 
   XML_READONLY = 1 << 2,
 
+  /*
+   * Count nodes and attributes with a fast pre-pass (see xml_prescan()) and
+   * allocate document memory once instead of growing it page by page. This
+   * pays off for large documents, counts are stored in doc->prescan.
+   */
+  XML_PRESCAN  = 1 << 3,
+
+  /*
+   * Keep comments as XML_COMMENT nodes, they are skipped by default. CDATA
+   * sections are always kept as XML_CDATA nodes. Comments and CDATA outside
+   * of root element are skipped.
+   */
+  XML_COMMENTS = 1 << 4,
+
+  /*
+   * Discard the tree if document is malformed: memory pages are released
+   * and doc->root is NULL, only doc->error is valid. Without this option
+   * nodes which are parsed until the error are kept, elements which are open
+   * at the error are closed. In both cases parsing stops at first error, see
+   * xml_error_t.
+   */
+  XML_FAILFAST = 1 << 5,
+
+  /*
+   * Intern tags and prefixes into symbol table of document and store atom
+   * (integer) of tag in xml->atom, so tags can be compared as integers or
+   * dispatched with a switch. Names can be registered to get stable atoms,
+   * see xml/atom.h.
+   */
+  XML_ATOMS    = 1 << 6,
+
   /* --------------------- DEFAULT OPTIONS ------------------------------------
    *
    * Option 1: NULL Terminator for Strings
@@ -69,12 +100,117 @@ typedef enum xml_options_t {
  * @param[in] contents XML string
  * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
  *
- * @return xml document which contains xml object as root object
+ * @return xml document which contains xml object as root object, check
+ *         doc->error.code to know if document is well-formed
  */
 XML_INLINE
 xml_doc_t*
 xml_parse(const char * __restrict contents, xml_options_t options);
 
+/*!
+ * @brief parse xml string with explicit length
+ *
+ * same as xml_parse() but contents doesn't need to be NULL terminated, parser
+ * is bounded by len and never reads past contents + len. So you can parse
+ * directly from network buffers, slices of a larger buffer or read-only
+ * mappings without copying contents to a NULL terminated buffer.
+ *
+ * If XML_READONLY is not used then parser still writes null terminators into
+ * contents (inside of [contents, contents + len) range), use XML_READONLY for
+ * read-only memory.
+ *
+ * @param[in] contents XML string (may not be NULL terminated)
+ * @param[in] len      byte length of contents
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ *
+ * @return xml document which contains xml object as root object
+ */
+XML_INLINE
+xml_doc_t*
+xml_parse_n(const char * __restrict contents,
+            size_t                   len,
+            xml_options_t            options);
+
+/*!
+ * @brief parse xml string into an existing document
+ *
+ * document is reset with xml_doc_reset() before parsing, so its memory pages
+ * are reused instead of allocating new ones. This is useful when many
+ * documents are parsed one after another e.g. a document per thread:
+ *
+ *   doc = xml_doc_new(NULL);
+ *   while (...) {
+ *     xml_parse_doc(doc, contents, len, XML_DEFAULTS);
+ *     ...
+ *   }
+ *   xml_free(doc);
+ *
+ * @param[in] doc      document which is created by xml_doc_new()
+ * @param[in] contents XML string (may not be NULL terminated)
+ * @param[in] len      byte length of contents
+ * @param[in] options  options use XML_DEFAULTS or XML_NONE for default
+ *
+ * @return doc or NULL if doc or contents is NULL
+ */
+XML_INLINE
+xml_doc_t*
+xml_parse_doc(xml_doc_t  * __restrict doc,
+              const char * __restrict contents,
+              size_t                  len,
+              xml_options_t           options);
+
+/*!
+ * @brief count nodes and attributes without parsing
+ *
+ * this is a vectorized counting pass over contents ('<' and '=' bytes), it
+ * can be used to preallocate caller's own structures before parsing. Counts
+ * are estimations, see xml_prescan_t.
+ *
+ * @param[in]  contents XML string (may not be NULL terminated)
+ * @param[in]  len      byte length of contents
+ * @param[out] counts   counts
+ */
+XML_INLINE
+void
+xml_prescan(const char    * __restrict contents,
+            size_t                     len,
+            xml_prescan_t * __restrict counts);
+
+/*!
+ * @brief create an empty document to parse into with xml_parse_doc()
+ *
+ * all memory of document (including itself) is allocated with allocator,
+ * allocator is copied into document.
+ *
+ * @param[in] allocator allocator or NULL to use malloc / free
+ * @return document or NULL if allocation fails, free it with xml_free()
+ */
+XML_INLINE
+xml_doc_t*
+xml_doc_new(const xml_allocator_t * __restrict allocator);
+
+/*!
+ * @brief rewind document's memory for next parse, pages are kept
+ *
+ * all nodes of document are invalidated, mapped contents (see xml/file.h) is
+ * unmapped. Memory is released by xml_free() only.
+ *
+ * @param[in] doc document
+ */
+XML_INLINE
+void
+xml_doc_reset(xml_doc_t * __restrict doc);
+
+/*!
+ * @brief description of error code e.g. for logs
+ *
+ * @param[in] code error code, see doc->error
+ * @return constant string
+ */
+XML_INLINE
+const char*
+xml_error_str(xml_error_code_t code);
+
 /*!
  * @brief frees xml document and its allocated memory
  */
@@ -82,9 +218,19 @@ XML_INLINE
 void
 xml_free(xml_doc_t * __restrict jsondoc);
 
+/*
+ * elements which have this number of attributes or more get a hashed index
+ * of attributes while parsing, see xmla_index(). Use 0 to disable it.
+ */
+#ifndef XML_ATTR_INDEX_MIN
+#  define XML_ATTR_INDEX_MIN 16
+#endif
+
 /*!
 * @brief get an attribute by name for given XML element
 *
+* lookup is O(1) if element has an attribute index, see xmla_index()
+*
 * @param[in] object   xml element
 * @param[in] name     attribute name to find
 * @return attribute (xml_attr_t)
@@ -117,9 +263,28 @@ xmla_packed(const xml_t * __restrict object,
             uint64_t                 packed,
             size_t                   namesize);
 
+/*!
+ * @brief build hashed index of attributes of element, xmla*() use it
+ *
+ * parser builds it for elements which have XML_ATTR_INDEX_MIN attributes or
+ * more, this can be used to build it for any element on demand. Index is
+ * allocated in document memory, it is rebuilt if it exists. It is kept by
+ * document not by element (nodes don't grow), so it is used while element is
+ * in tree of doc->root.
+ *
+ * @param[in] doc    document of element
+ * @param[in] object xml element
+ * @return false if allocation fails
+ */
+XML_INLINE
+bool
+xmla_index(xml_doc_t * __restrict doc, xml_t * __restrict object);
+
 /*!
 * @brief get an child element by name for given XML element
 *
+* lookup is O(1) if element has a child index, see xml_elem_index()
+*
 * @param[in] object   xml element
 * @param[in] name     element name to find
 * @return element (xml_t)
@@ -152,9 +317,30 @@ xml_elem_packed(const xml_t * __restrict object,
                 uint64_t                 packed,
                 size_t                   namesize);
 
+/*!
+ * @brief build hashed index of child elements by tag, xml_elem*() use it
+ *
+ * Each child element is also linked to its next sibling with same tag, so
+ * xml_elem_next*() with tag of current element is O(1) and iterating over
+ * repeated elements doesn't visit other siblings. Use it for wide elements
+ * which are queried many times e.g. root of a large export. Index is
+ * allocated in document memory, it is rebuilt if it exists. Like
+ * xmla_index() it is used while element is in tree of doc->root.
+ *
+ * @param[in] doc    document of element
+ * @param[in] object xml element
+ * @return false if allocation fails
+ */
+XML_INLINE
+bool
+xml_elem_index(xml_doc_t * __restrict doc, xml_t * __restrict object);
+
 /*!
 * @brief get an child element by name for given XML element
 *
+* O(1) if name is tag of current and parent has a child index, see
+* xml_elem_index()
+*
 * @param[in] current  current xml element
 * @param[in] name     element name to find
 * @return element (xml_t)
@@ -187,6 +373,36 @@ xml_elem_next_packed(const xml_t * __restrict current,
                      uint64_t                 packed,
                      size_t                   namesize);
 
+/*!
+ * @brief bytes of element in contents, from '<' to '>' of its end tag
+ *
+ * Parser marks elements which source has nothing but their nodes (no
+ * comments without XML_COMMENTS, processing instructions or whitespace-only
+ * text) as exact (xml_parse_n(), xml_parse_parallel(), not push parser), end
+ * of source is found on demand. Only for XML_READONLY documents, else parser
+ * writes null terminators into contents.
+ *
+ * @param[in]  object xml element
+ * @param[out] size   size of element in bytes
+ * @return begin of element or NULL if element is not exact, it is changed or
+ *         document is not readonly
+ */
+XML_INLINE
+const char*
+xml_src(const xml_t * __restrict object, size_t * __restrict size);
+
+/*!
+ * @brief mark element as changed after parse, its ancestors are marked too
+ *
+ * call it after changing tag, attributes or children of an element, so
+ * serializer doesn't copy it from contents, see XML_SERIALIZE_SPANS
+ *
+ * @param[in] object changed node
+ */
+XML_INLINE
+void
+xml_touch(xml_t * __restrict object);
+
 #include "impl/impl_parse.h"
 #include "impl/impl_common.h"
 #include "objmap.h"
@@ -6,50 +6,129 @@
  */
 
 #include "../include/xml/call/xml.h"
+#include "../include/xml/file.h"
+#include "../include/xml/tape.h"
+#include "../include/xml/pool.h"
 
 static
 xml_doc_t*
-xmlc__parse_reverse(const char * __restrict contents) {
-  return xml_parse(contents, XML_REVERSE | XML_PREFIXES);
+xmlc__parse_reverse(const char * __restrict contents,
+                    size_t                   len,
+                    xml_options_t            options) {
+  return xml_parse_n(contents, len, options | XML_REVERSE | XML_PREFIXES);
 }
 
 static
 xml_doc_t*
-xmlc__parse_reverse_nopref(const char * __restrict contents) {
-  return xml_parse(contents, XML_REVERSE);
+xmlc__parse_reverse_nopref(const char * __restrict contents,
+                           size_t                   len,
+                           xml_options_t            options) {
+  return xml_parse_n(contents, len, options | XML_REVERSE);
 }
 
 static
 xml_doc_t*
-xmlc__parse_normal(const char * __restrict contents) {
-  return xml_parse(contents, XML_PREFIXES);
+xmlc__parse_normal(const char * __restrict contents,
+                   size_t                   len,
+                   xml_options_t            options) {
+  return xml_parse_n(contents, len, options | XML_PREFIXES);
 }
 
 static
 xml_doc_t*
-xmlc__parse_normal_nopref(const char * __restrict contents) {
-  return xml_parse(contents, XML_DEFAULTS);
+xmlc__parse_normal_nopref(const char * __restrict contents,
+                          size_t                   len,
+                          xml_options_t            options) {
+  return xml_parse_n(contents, len, options);
 }
 
 XML_EXPORT
 xml_doc_t*
-xmlc_parse(const char * __restrict contents, xml_options_t options) {
+xmlc_parse_n(const char * __restrict contents,
+             size_t                   len,
+             xml_options_t            options) {
   bool reverse, separatePrefixes;
 
   reverse          = options & XML_REVERSE;
   separatePrefixes = options & XML_PREFIXES;
+  options         &= ~(XML_REVERSE | XML_PREFIXES);
 
   if (!reverse) {
     if (separatePrefixes)
-      return xmlc__parse_normal(contents);
+      return xmlc__parse_normal(contents, len, options);
     else
-      return xmlc__parse_normal_nopref(contents);
+      return xmlc__parse_normal_nopref(contents, len, options);
   }
   
   if (separatePrefixes)
-    return xmlc__parse_reverse(contents);
+    return xmlc__parse_reverse(contents, len, options);
   else
-    return xmlc__parse_reverse_nopref(contents);
+    return xmlc__parse_reverse_nopref(contents, len, options);
+}
+
+XML_EXPORT
+xml_doc_t*
+xmlc_parse(const char * __restrict contents, xml_options_t options) {
+  if (!contents)
+    return NULL;
+
+  return xmlc_parse_n(contents, strlen(contents), options);
+}
+
+XML_EXPORT
+xml_doc_t*
+xmlc_parse_doc(xml_doc_t  * __restrict doc,
+               const char * __restrict contents,
+               size_t                  len,
+               xml_options_t           options) {
+  return xml_parse_doc(doc, contents, len, options);
+}
+
+XML_EXPORT
+xml_doc_t*
+xmlc_doc_new(const xml_allocator_t * __restrict allocator) {
+  return xml_doc_new(allocator);
+}
+
+XML_EXPORT
+void
+xmlc_doc_reset(xml_doc_t * __restrict doc) {
+  xml_doc_reset(doc);
+}
+
+XML_EXPORT
+void
+xmlc_pool_init(xml_pool_t            * __restrict pool,
+               size_t                             maxmem,
+               const xml_allocator_t * __restrict allocator) {
+  xml_pool_init(pool, maxmem, allocator);
+}
+
+XML_EXPORT
+xml_doc_t*
+xmlc_pool_parse(xml_pool_t * __restrict pool,
+                const char * __restrict contents,
+                size_t                  len,
+                xml_options_t           options) {
+  return xml_pool_parse(pool, contents, len, options);
+}
+
+XML_EXPORT
+void
+xmlc_pool_release(xml_pool_t * __restrict pool, xml_doc_t * __restrict doc) {
+  xml_pool_release(pool, doc);
+}
+
+XML_EXPORT
+void
+xmlc_pool_destroy(xml_pool_t * __restrict pool) {
+  xml_pool_destroy(pool);
+}
+
+XML_EXPORT
+xml_doc_t*
+xmlc_parse_file(const char * __restrict path, xml_options_t options) {
+  return xml_parse_file(path, options);
 }
 
 XML_EXPORT
@@ -57,3 +136,17 @@ void
 xmlc_free(xml_doc_t * __restrict jsondoc) {
   xml_free(jsondoc);
 }
+
+XML_EXPORT
+xml_tape_t*
+xmlc_parse_tape(const char * __restrict contents,
+                size_t                   len,
+                xml_options_t            options) {
+  return xml_parse_tape(contents, len, options);
+}
+
+XML_EXPORT
+void
+xmlc_tape_free(xml_tape_t * __restrict tape) {
+  xml_tape_free(tape);
+}